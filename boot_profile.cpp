@@ -0,0 +1,53 @@
+#include "boot_profile.h"
+#include <Arduino.h>
+
+const char* BOOT_PHASE_NAMES[BOOT_PHASE_COUNT] = {
+  "start",
+  "outputsSafe",
+  "settingsLoaded",
+  "sensorsReady",
+  "controlReady",
+  "fsMounted",
+  "wifiReady",
+  "webReady",
+  "rtcReady"
+};
+
+// Ditulis dari loop() dan dari task boot latar belakang: satu slot per fase, tanpa lock
+volatile unsigned long bootPhaseMicros[BOOT_PHASE_COUNT];
+
+void markBootPhase(BootPhase phase) {
+  if (phase >= BOOT_PHASE_COUNT || bootPhaseMicros[phase] != 0) return;
+  unsigned long now = micros();
+  bootPhaseMicros[phase] = now ? now : 1;
+}
+
+unsigned long getBootPhaseMicros(BootPhase phase) {
+  if (phase >= BOOT_PHASE_COUNT) return 0;
+  return bootPhaseMicros[phase];
+}
+
+void printBootProfile() {
+  Serial.println("[BOOT] Phase timing (ms since reset):");
+  for (int i = 0; i < BOOT_PHASE_COUNT; i++) {
+    unsigned long t = bootPhaseMicros[i];
+    Serial.print("  ");
+    Serial.print(BOOT_PHASE_NAMES[i]);
+    Serial.print(": ");
+    Serial.println(t ? String(t / 1000.0, 2) : String("-"));
+  }
+  Serial.println("[BOOT] time-to-control: " + String(bootPhaseMicros[BOOT_CONTROL_READY] / 1000.0, 2) + " ms");
+  Serial.println("[BOOT] time-to-web: " + String(bootPhaseMicros[BOOT_WEB_READY] / 1000.0, 2) + " ms");
+}
+
+String getBootProfileJSON() {
+  String json = "{";
+  for (int i = 0; i < BOOT_PHASE_COUNT; i++) {
+    if (i > 0) json += ",";
+    json += "\"" + String(BOOT_PHASE_NAMES[i]) + "\":" + String(bootPhaseMicros[i] / 1000.0, 2);
+  }
+  json += ",\"timeToControl\":" + String(bootPhaseMicros[BOOT_CONTROL_READY] / 1000.0, 2);
+  json += ",\"timeToWeb\":" + String(bootPhaseMicros[BOOT_WEB_READY] / 1000.0, 2);
+  json += "}";
+  return json;
+}
@@ -0,0 +1,31 @@
+#ifndef BOOT_PROFILE_H
+#define BOOT_PROFILE_H
+
+#include <Arduino.h>
+
+// ==================== FASE BOOT ====================
+// Urutan fase boot produksi. Setiap fase dicatat sekali dengan micros().
+enum BootPhase {
+  BOOT_START = 0,          // Masuk setup()
+  BOOT_OUTPUTS_SAFE,       // Semua aktuator OFF
+  BOOT_SETTINGS_LOADED,    // Setting dimuat dari NVS
+  BOOT_SENSORS_READY,      // Sensor kontrol siap (suhu, flow, TDS)
+  BOOT_CONTROL_READY,      // Loop kontrol mulai (time-to-control)
+  BOOT_FS_MOUNTED,         // SPIFFS terpasang (task latar belakang)
+  BOOT_WIFI_READY,         // SoftAP aktif
+  BOOT_WEB_READY,          // Web server menerima request (time-to-web)
+  BOOT_RTC_READY,          // RTC diprobe
+  BOOT_PHASE_COUNT
+};
+
+// Catat waktu fase (hanya yang pertama kali dihitung)
+void markBootPhase(BootPhase phase);
+
+// Waktu fase dalam mikrodetik sejak boot (0 jika belum tercapai)
+unsigned long getBootPhaseMicros(BootPhase phase);
+
+// Cetak ringkasan ke Serial dan dalam format JSON
+void printBootProfile();
+String getBootProfileJSON();
+
+#endif
@@ -1,12 +1,24 @@
 #include "digital_control.h"
 #include "pins.h" // <-- Penting! Agar bisa mengakses COUNTDOWN_BUTTON, BUZZER_PIN, dll
+#include "trace_recorder.h"
+#include "energy_accounting.h"
 #include <Arduino.h>
 
+// State output aktuator (diperbarui oleh setter)
+bool valveDrainState = false;
+bool valveInletState = false;
+bool pumpUVState = false;
+bool compressorState = false;
+
 void initDigitalPins() {
-  // Inisialisasi pin INPUT
-  pinMode(COUNTDOWN_BUTTON, INPUT_PULLUP);
-  pinMode(FLOAT_SENSOR_PIN, INPUT_PULLUP);
-  pinMode(FLOW_SWITCH_PIN, INPUT_PULLUP);
+  // Set level LOW (aktuator OFF) sebelum pin dijadikan OUTPUT,
+  // supaya relay tidak sempat glitch ON saat boot
+  digitalWrite(BUZZER_PIN, LOW);
+  digitalWrite(COUNTDOWN_LED, LOW);
+  digitalWrite(VALVE_DRAIN_PIN, LOW);
+  digitalWrite(VALVE_INLET_PIN, LOW);
+  digitalWrite(PUMP_UV_PIN, LOW);
+  digitalWrite(COMPRESSOR_PIN, LOW);
 
   // Inisialisasi pin OUTPUT
   pinMode(BUZZER_PIN, OUTPUT);
@@ -16,13 +28,10 @@ void initDigitalPins() {
   pinMode(PUMP_UV_PIN, OUTPUT);
   pinMode(COMPRESSOR_PIN, OUTPUT);
 
-  // Set awal semua output ke LOW (aktuator OFF)
-  digitalWrite(BUZZER_PIN, LOW);
-  digitalWrite(COUNTDOWN_LED, LOW);
-  digitalWrite(VALVE_DRAIN_PIN, LOW);
-  digitalWrite(VALVE_INLET_PIN, LOW);
-  digitalWrite(PUMP_UV_PIN, LOW);
-  digitalWrite(COMPRESSOR_PIN, LOW);
+  // Inisialisasi pin INPUT
+  pinMode(COUNTDOWN_BUTTON, INPUT_PULLUP);
+  pinMode(FLOAT_SENSOR_PIN, INPUT_PULLUP);
+  pinMode(FLOW_SWITCH_PIN, INPUT_PULLUP);
 
   Serial.println("Digital pins initialized.");
 }
@@ -30,42 +39,61 @@ void initDigitalPins() {
 // --- Fungsi untuk mengatur output ---
 void setBuzzer(bool state) {
   digitalWrite(BUZZER_PIN, state ? HIGH : LOW);
+  traceActuator(BUZZER_PIN, state);
 }
 
 void setCountdownLED(bool state) {
   digitalWrite(COUNTDOWN_LED, state ? HIGH : LOW);
+  traceActuator(COUNTDOWN_LED, state);
 }
 
 void setValveDrain(bool state) {
   digitalWrite(VALVE_DRAIN_PIN, state ? HIGH : LOW);
+  valveDrainState = state;
+  traceActuator(VALVE_DRAIN_PIN, state);
+  accountRelayState(RELAY_VALVE_DRAIN, state);
 }
 
 void setValveInlet(bool state) {
   digitalWrite(VALVE_INLET_PIN, state ? HIGH : LOW);
+  valveInletState = state;
+  traceActuator(VALVE_INLET_PIN, state);
+  accountRelayState(RELAY_VALVE_INLET, state);
 }
 
 void setPumpUV(bool state) {
   digitalWrite(PUMP_UV_PIN, state ? HIGH : LOW);
+  pumpUVState = state;
+  traceActuator(PUMP_UV_PIN, state);
+  accountRelayState(RELAY_PUMP_UV, state);
 }
 
 void setCompressor(bool state) {
   digitalWrite(COMPRESSOR_PIN, state ? HIGH : LOW);
+  compressorState = state;
+  traceActuator(COMPRESSOR_PIN, state);
+  accountRelayState(RELAY_COMPRESSOR, state);
 }
 
+bool isValveDrainOpen() { return valveDrainState; }
+bool isValveInletOpen() { return valveInletState; }
+bool isPumpUVOn() { return pumpUVState; }
+bool isCompressorOn() { return compressorState; }
+
 // --- Fungsi untuk membaca input ---
 bool isCountdownButtonPressed() {
   // INPUT_PULLUP: LOW = ditekan
-  return digitalRead(COUNTDOWN_BUTTON) == LOW;
+  return traceDigitalInput(COUNTDOWN_BUTTON, digitalRead(COUNTDOWN_BUTTON) == LOW);
 }
 
 bool isFloatSensorLow() {
   // INPUT_PULLUP: LOW = air rendah/kosong
-  return digitalRead(FLOAT_SENSOR_PIN) == HIGH;
+  return traceDigitalInput(FLOAT_SENSOR_PIN, digitalRead(FLOAT_SENSOR_PIN) == HIGH);
 }
 
 bool isFlowSwitchOn() {
   // INPUT_PULLUP: HIGH = aliran OK
-  return digitalRead(FLOW_SWITCH_PIN) == HIGH;
+  return traceDigitalInput(FLOW_SWITCH_PIN, digitalRead(FLOW_SWITCH_PIN) == HIGH);
 }
 
 // --- Fungsi umum (opsional) ---
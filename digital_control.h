@@ -14,6 +14,12 @@ void setValveInlet(bool state);
 void setPumpUV(bool state);
 void setCompressor(bool state);
 
+// State output terakhir yang diset (tanpa membaca ulang pin)
+bool isValveDrainOpen();
+bool isValveInletOpen();
+bool isPumpUVOn();
+bool isCompressorOn();
+
 // Fungsi untuk membaca input
 bool isCountdownButtonPressed();
 bool isFloatSensorLow(); // HIGH = penuh, LOW = kosong
@@ -0,0 +1,306 @@
+#include "energy_accounting.h"
+#include "system_manager.h" // getActiveProcessMask()
+#include "sensor_reader.h"  // getRTCEpoch(), flowPulsesToLitres()
+#include "settings_store.h" // Daya relay, settingsChecksum()
+#include <Arduino.h>
+#include <Preferences.h>
+
+// Isi blob di NVS (field baru ditambahkan di akhir, seperti RuntimeSettings)
+struct EnergyStore {
+  RelayCounters relays[RELAY_COUNT];
+  double litresIn = 0;
+  uint32_t batchCount = 0;
+  uint8_t historyHead = 0;      // Slot berikutnya di ring riwayat
+  uint8_t historyCount = 0;
+  BatchRecord history[ENERGY_BATCH_HISTORY];
+};
+
+struct EnergyBlobHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t size;      // sizeof(EnergyStore) saat blob ditulis
+  uint32_t checksum;
+};
+
+const char* ENERGY_NAMESPACE = "icebatch";
+const char* ENERGY_KEY = "energy";
+const char* RELAY_NAMES[RELAY_COUNT] = { "compressor", "pumpUV", "valveInlet", "valveDrain" };
+
+EnergyStore energy;
+
+// State relay saat ini (on-time yang berjalan belum masuk counter)
+bool relayOn[RELAY_COUNT];
+unsigned long relayChangedTime[RELAY_COUNT];
+
+// Batch aktif: counter saat batch dibuka, hasil batch = selisihnya
+bool batchOpen = false;
+BatchRecord currentBatch;
+RelayCounters batchStartRelays[RELAY_COUNT];
+double batchStartLitres = 0;
+unsigned long batchStartTime = 0;
+bool batchCoolingStarted = false;
+unsigned long batchCoolingStartTime = 0;
+uint8_t lastProcessMask = 0;
+
+// Write-behind
+bool energyDirty = false;
+bool energyActivity = false; // Ada start relay/liter baru sejak simpan terakhir
+unsigned long energyChangedTime = 0;
+unsigned long lastEnergySaveTime = 0;
+
+// ==================== COUNTER RELAY ====================
+
+float relayPowerW(int relay) {
+  switch (relay) {
+    case RELAY_COMPRESSOR: return settings.compressorPowerW;
+    case RELAY_PUMP_UV:    return settings.pumpUVPowerW;
+    default:               return settings.valvePowerW;
+  }
+}
+
+// Pindahkan on-time yang berjalan ke counter (dengan daya yang berlaku saat ini)
+void flushRelay(int relay, unsigned long now) {
+  if (!relayOn[relay]) return;
+  unsigned long elapsed = now - relayChangedTime[relay];
+  energy.relays[relay].onTimeMs += elapsed;
+  energy.relays[relay].energyWh += elapsed * relayPowerW(relay) / 3600000.0;
+  relayChangedTime[relay] = now;
+}
+
+void flushAllRelays(unsigned long now) {
+  for (int i = 0; i < RELAY_COUNT; i++) {
+    flushRelay(i, now);
+  }
+}
+
+void accountRelayState(RelayId relay, bool on) {
+  if (relayOn[relay] == on) return;
+  unsigned long now = millis();
+  flushRelay(relay, now);
+  relayOn[relay] = on;
+  relayChangedTime[relay] = now;
+  if (on) energy.relays[relay].starts++;
+  energyActivity = true;
+}
+
+void accountFlowPulses(unsigned long pulses) {
+  if (pulses == 0 || !relayOn[RELAY_VALVE_INLET]) return;
+  energy.litresIn += flowPulsesToLitres(pulses);
+  energyActivity = true;
+}
+
+// ==================== BATCH ====================
+
+void openBatch(unsigned long now) {
+  flushAllRelays(now);
+  batchOpen = true;
+  currentBatch = BatchRecord();
+  currentBatch.id = energy.batchCount + 1;
+  currentBatch.startEpoch = getRTCEpoch();
+  memcpy(batchStartRelays, energy.relays, sizeof(batchStartRelays));
+  batchStartLitres = energy.litresIn;
+  batchStartTime = now;
+  batchCoolingStarted = false;
+  Serial.println("Energy: Batch #" + String(currentBatch.id) + " dimulai.");
+}
+
+// Isi record batch aktif dari selisih counter sampai now
+void fillBatchRecord(BatchRecord& record, unsigned long now) {
+  flushAllRelays(now);
+  record.durationMs = now - batchStartTime;
+  record.fillMs = energy.relays[RELAY_VALVE_INLET].onTimeMs - batchStartRelays[RELAY_VALVE_INLET].onTimeMs;
+  record.drainMs = energy.relays[RELAY_VALVE_DRAIN].onTimeMs - batchStartRelays[RELAY_VALVE_DRAIN].onTimeMs;
+  record.compressorOnMs = energy.relays[RELAY_COMPRESSOR].onTimeMs - batchStartRelays[RELAY_COMPRESSOR].onTimeMs;
+  record.compressorStarts = energy.relays[RELAY_COMPRESSOR].starts - batchStartRelays[RELAY_COMPRESSOR].starts;
+  record.litres = energy.litresIn - batchStartLitres;
+  double wh = 0;
+  for (int i = 0; i < RELAY_COUNT; i++) {
+    wh += energy.relays[i].energyWh - batchStartRelays[i].energyWh;
+  }
+  record.energyWh = wh;
+}
+
+void closeBatch(unsigned long now) {
+  fillBatchRecord(currentBatch, now);
+  batchOpen = false;
+
+  energy.batchCount = currentBatch.id;
+  energy.history[energy.historyHead] = currentBatch;
+  energy.historyHead = (energy.historyHead + 1) % ENERGY_BATCH_HISTORY;
+  if (energy.historyCount < ENERGY_BATCH_HISTORY) energy.historyCount++;
+
+  energyDirty = true;
+  energyChangedTime = now;
+  Serial.println("Energy: Batch #" + String(currentBatch.id) + " selesai, " +
+                 String(currentBatch.energyWh, 1) + " Wh, " + String(currentBatch.litres, 1) + " L.");
+}
+
+void markBatchTargetReached() {
+  if (!batchOpen || !batchCoolingStarted || currentBatch.timeToTargetMs != 0) return;
+  currentBatch.timeToTargetMs = millis() - batchCoolingStartTime;
+}
+
+void updateEnergyAccounting(unsigned long now) {
+  uint8_t mask = getActiveProcessMask();
+  uint8_t started = mask & ~lastProcessMask;
+  uint8_t stopped = lastProcessMask & ~mask;
+  lastProcessMask = mask;
+
+  // Filling baru menutup batch sebelumnya yang belum di-drain
+  if (started & (1 << PROCESS_FILLING)) {
+    if (batchOpen) closeBatch(now);
+    openBatch(now);
+  }
+  if (started & (1 << PROCESS_COOLING)) {
+    if (!batchOpen) openBatch(now);
+    if (!batchCoolingStarted) {
+      batchCoolingStarted = true;
+      batchCoolingStartTime = now;
+    }
+  }
+  if ((stopped & (1 << PROCESS_DRAINING)) && batchOpen) {
+    closeBatch(now);
+  }
+}
+
+// ==================== BLOB NVS ====================
+
+void initEnergyAccounting() {
+  energy = EnergyStore();
+  unsigned long now = millis();
+  for (int i = 0; i < RELAY_COUNT; i++) {
+    relayOn[i] = false;
+    relayChangedTime[i] = now;
+  }
+  lastEnergySaveTime = now;
+
+  Preferences prefs;
+  if (!prefs.begin(ENERGY_NAMESPACE, true)) {
+    Serial.println("Energy: NVS kosong, counter mulai dari nol.");
+    return;
+  }
+
+  uint8_t blob[sizeof(EnergyBlobHeader) + sizeof(EnergyStore)];
+  size_t len = prefs.getBytes(ENERGY_KEY, blob, sizeof(blob));
+  prefs.end();
+
+  EnergyBlobHeader header;
+  if (len < sizeof(header)) {
+    Serial.println("Energy: Belum tersimpan, counter mulai dari nol.");
+    return;
+  }
+  memcpy(&header, blob, sizeof(header));
+
+  const uint8_t* payload = blob + sizeof(header);
+  if (header.magic != ENERGY_MAGIC || header.version > ENERGY_VERSION ||
+      header.size > sizeof(EnergyStore) || len < sizeof(header) + header.size ||
+      header.checksum != settingsChecksum(payload, header.size)) {
+    Serial.println("Energy: Blob tidak valid, counter mulai dari nol.");
+    return;
+  }
+
+  memcpy(&energy, payload, header.size);
+  Serial.println("Energy: Counter dimuat dari NVS (" + String(energy.batchCount) + " batch).");
+}
+
+bool writeEnergyBlob() {
+  uint8_t blob[sizeof(EnergyBlobHeader) + sizeof(EnergyStore)];
+  EnergyBlobHeader header;
+  header.magic = ENERGY_MAGIC;
+  header.version = ENERGY_VERSION;
+  header.size = sizeof(EnergyStore);
+  header.checksum = settingsChecksum((const uint8_t*)&energy, sizeof(EnergyStore));
+  memcpy(blob, &header, sizeof(header));
+  memcpy(blob + sizeof(header), &energy, sizeof(EnergyStore));
+
+  Preferences prefs;
+  if (!prefs.begin(ENERGY_NAMESPACE, false)) return false;
+  bool ok = prefs.putBytes(ENERGY_KEY, blob, sizeof(blob)) == sizeof(blob);
+  prefs.end();
+  return ok;
+}
+
+void serviceEnergyStore() {
+  unsigned long now = millis();
+
+  // On-time relay yang sedang menyala disimpan berkala, bukan setiap perubahan
+  if (!energyDirty && now - lastEnergySaveTime >= ENERGY_SAVE_INTERVAL_MS) {
+    for (int i = 0; i < RELAY_COUNT; i++) {
+      if (relayOn[i]) energyActivity = true;
+    }
+    if (energyActivity) energyDirty = true;
+    else lastEnergySaveTime = now;
+  }
+  if (!energyDirty) return;
+  // Coalescing: batch yang baru ditutup ditunggu sampai tidak ada update lain
+  if (now - energyChangedTime < ENERGY_WRITE_DELAY_MS) return;
+
+  flushAllRelays(now);
+  if (writeEnergyBlob()) {
+    energyDirty = false;
+    energyActivity = false;
+    lastEnergySaveTime = now;
+  } else {
+    energyChangedTime = now; // Coba lagi nanti
+    Serial.println("Energy: Gagal menyimpan ke NVS.");
+  }
+}
+
+// ==================== JSON ====================
+
+void appendBatchJSON(String& json, const BatchRecord& b) {
+  json += "{\"id\":" + String(b.id);
+  json += ",\"startEpoch\":" + String(b.startEpoch);
+  json += ",\"durationS\":" + String(b.durationMs / 1000.0, 1);
+  json += ",\"fillS\":" + String(b.fillMs / 1000.0, 1);
+  json += ",\"drainS\":" + String(b.drainMs / 1000.0, 1);
+  json += ",\"timeToTargetS\":" + String(b.timeToTargetMs / 1000.0, 1);
+  json += ",\"compressorOnS\":" + String(b.compressorOnMs / 1000.0, 1);
+  json += ",\"compressorStarts\":" + String(b.compressorStarts);
+  json += ",\"compressorDutyPct\":" + String(b.durationMs ? b.compressorOnMs * 100.0 / b.durationMs : 0.0, 1);
+  json += ",\"litres\":" + String(b.litres, 2);
+  json += ",\"energyWh\":" + String(b.energyWh, 2);
+  json += "}";
+}
+
+String getEnergyJSON() {
+  unsigned long now = millis();
+  flushAllRelays(now);
+
+  String json = "{\"relays\":{";
+  double totalWh = 0;
+  for (int i = 0; i < RELAY_COUNT; i++) {
+    const RelayCounters& r = energy.relays[i];
+    totalWh += r.energyWh;
+    if (i > 0) json += ",";
+    json += "\"" + String(RELAY_NAMES[i]) + "\":{";
+    json += "\"on\":" + String(relayOn[i] ? "true" : "false");
+    json += ",\"onTimeS\":" + String((unsigned long)(r.onTimeMs / 1000));
+    json += ",\"starts\":" + String(r.starts);
+    json += ",\"energyWh\":" + String(r.energyWh, 1);
+    json += "}";
+  }
+  json += "},\"energyWh\":" + String(totalWh, 1);
+  json += ",\"litres\":" + String(energy.litresIn, 1);
+  json += ",\"batches\":" + String(energy.batchCount);
+
+  json += ",\"current\":";
+  if (batchOpen) {
+    BatchRecord live = currentBatch;
+    fillBatchRecord(live, now);
+    appendBatchJSON(json, live);
+  } else {
+    json += "null";
+  }
+
+  // Riwayat, terbaru dulu
+  json += ",\"history\":[";
+  for (int i = 0; i < energy.historyCount; i++) {
+    int index = (energy.historyHead + ENERGY_BATCH_HISTORY - 1 - i) % ENERGY_BATCH_HISTORY;
+    if (i > 0) json += ",";
+    appendBatchJSON(json, energy.history[index]);
+  }
+  json += "],\"unsaved\":" + String(energyDirty ? "true" : "false");
+  json += "}";
+  return json;
+}
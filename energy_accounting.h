@@ -0,0 +1,67 @@
+#ifndef ENERGY_ACCOUNTING_H
+#define ENERGY_ACCOUNTING_H
+
+#include <Arduino.h>
+
+// ==================== AKUNTANSI ENERGI & PRODUKSI ====================
+// Setter aktuator (digital_control) melaporkan setiap perubahan state relay.
+// On-time dan jumlah start diintegrasikan per relay; energi = on-time x daya
+// dari RuntimeSettings (compressorPowerW, pumpUVPowerW, valvePowerW).
+// Satu batch dibuka saat filling (atau cooling) dimulai tanpa batch aktif dan
+// ditutup saat draining selesai; isinya selisih counter selama batch tersebut.
+// Counter + riwayat batch disimpan di NVS dengan penulisan yang digabung.
+#define ENERGY_MAGIC             0x45544349UL // "ICTE"
+#define ENERGY_VERSION           1
+#define ENERGY_WRITE_DELAY_MS    5000         // Setelah batch ditutup, tunggu update lain
+#define ENERGY_SAVE_INTERVAL_MS  600000UL     // Simpan on-time yang berjalan tiap 10 menit
+#define ENERGY_BATCH_HISTORY     10           // Jumlah batch terakhir yang disimpan
+
+enum RelayId {
+  RELAY_COMPRESSOR = 0,
+  RELAY_PUMP_UV,
+  RELAY_VALVE_INLET,
+  RELAY_VALVE_DRAIN,
+  RELAY_COUNT
+};
+
+struct RelayCounters {
+  uint64_t onTimeMs = 0;
+  uint32_t starts = 0;
+  double energyWh = 0;
+};
+
+struct BatchRecord {
+  uint32_t id = 0;
+  uint32_t startEpoch = 0;      // Waktu RTC saat batch dibuka, 0 jika RTC tidak valid
+  uint32_t durationMs = 0;
+  uint32_t fillMs = 0;          // Valve inlet terbuka
+  uint32_t drainMs = 0;         // Valve drain terbuka (termasuk draining awal filling)
+  uint32_t timeToTargetMs = 0;  // Dari cooling mulai sampai target pertama tercapai, 0 jika belum
+  uint32_t compressorOnMs = 0;
+  uint32_t compressorStarts = 0;
+  float litres = 0;             // Air masuk (pulsa flow selama valve inlet terbuka)
+  float energyWh = 0;           // Semua relay
+};
+
+// Muat counter dari NVS. Dipanggil dari setup() setelah initSettings().
+void initEnergyAccounting();
+
+// Dipanggil oleh setter di digital_control setiap kali output diset
+void accountRelayState(RelayId relay, bool on);
+
+// Pulsa flow per jendela dari sensor_reader (dihitung sebagai liter jika inlet terbuka)
+void accountFlowPulses(unsigned long pulses);
+
+// Cooling mencapai target untuk pertama kali (time-to-target batch aktif)
+void markBatchTargetReached();
+
+// Deteksi awal/akhir batch dari proses aktif. Dipanggil dari tick() setelah proses jalan.
+void updateEnergyAccounting(unsigned long now);
+
+// Tulis ke NVS jika ada perubahan. Dipanggil dari loop(), di luar tick().
+void serviceEnergyStore();
+
+// Counter relay, batch aktif dan riwayat batch dalam format JSON
+String getEnergyJSON();
+
+#endif
@@ -1,22 +1,168 @@
 #include <WiFi.h>
 #include <WebServer.h>
 #include <SPIFFS.h>
+#include "digital_control.h"
+#include "sensor_reader.h"
+#include "system_manager.h"
+#include "trace_recorder.h"
+#include "settings_store.h"
+#include "boot_profile.h"
+#include "telemetry.h"
+#include "response_cache.h"
+#include "sensor_diagnostics.h"
+#include "energy_accounting.h"
+#include "sensor_rollup.h"
 
 const char* ssid = "ESP32-Debug";
 
 WebServer server(80);
 
-void setup() {
-  Serial.begin(115200);
-  Serial.println("\n[SETUP] Initializing Debug Mode...");
+// ======== PROFIL BOOT ========
+// 0 = produksi: aktuator aman + loop kontrol dulu, SPIFFS/WiFi/RTC di task
+//     latar belakang, SPIFFS tidak pernah diformat otomatis
+// 1 = debug: SPIFFS diformat jika gagal mount, daftar file dan isi
+//     index.html dicetak ke Serial
+#define BOOT_PROFILE_DEBUG 0
 
-  // Mount SPIFFS
-  if (!SPIFFS.begin(true)) {
-    Serial.println("[ERROR] Failed to mount SPIFFS");
-    return;
-  }
-  Serial.println("[INFO] SPIFFS mounted");
+// Periode tick() kontrol. Sensor punya jadwal sendiri (lihat sensor_reader.h),
+// jadi tick tidak lagi tertahan konversi DS18B20 dan perlu dibatasi di sini.
+#define CONTROL_TICK_MS 100
+unsigned long lastTickTime = 0;
+
+// Buffer encode telemetri biner (dipakai bergantian oleh handler web)
+uint8_t telemetryBuffer[TELEMETRY_BUFFER_SIZE];
+
+// Diset oleh task boot setelah server.begin(); sebelum itu loop() tidak melayani web
+volatile bool webReady = false;
+
+void setupRoutes() {
+  // Serve index.html on root
+  server.on("/", HTTP_GET, []() {
+    File file = SPIFFS.open("/index.html", "r");
+    if (!file) {
+      Serial.println("[ERROR] /index.html not found");
+      server.send(404, "text/plain", "File not found");
+      return;
+    }
+    Serial.println("[INFO] Serving /index.html");
+    server.streamFile(file, "text/html");
+    file.close();
+  });
+
+  server.serveStatic("/script.js", SPIFFS, "/script.js");
+  server.serveStatic("/style.css", SPIFFS, "/style.css");
+
+  // Status sensor + proses: JSON (default) atau biner jika Accept meminta
+  // TELEMETRY_CONTENT_TYPE. Body diambil dari cache per snapshot, sama untuk
+  // semua klien; If-None-Match yang cocok dijawab 304 tanpa body.
+  server.on("/api/sensors", HTTP_GET, []() {
+    bool binary = acceptsBinaryTelemetry(server.header("Accept"));
+    String etag = getStatusETag(binary);
+    server.sendHeader("ETag", etag);
+    server.sendHeader("Cache-Control", "no-cache");
+    server.sendHeader("Vary", "Accept");
+    if (server.header("If-None-Match") == etag) {
+      server.send(304);
+      return;
+    }
+    if (binary) {
+      size_t len;
+      const uint8_t* body = getCachedStatusBinary(len);
+      server.send_P(200, TELEMETRY_CONTENT_TYPE, (const char*)body, len);
+    } else {
+      server.send(200, "application/json", getCachedStatusJSON());
+    }
+  });
+
+  // Riwayat sampel: ?since=<millis> untuk ambil yang lebih baru saja,
+  // ?mode=fixed untuk biner tanpa delta (default delta)
+  server.on("/api/history", HTTP_GET, []() {
+    uint32_t since = strtoul(server.arg("since").c_str(), NULL, 10);
+    server.sendHeader("Vary", "Accept");
+    if (acceptsBinaryTelemetry(server.header("Accept"))) {
+      TelemetryMode mode = server.arg("mode") == "fixed" ? TELEMETRY_FIXED : TELEMETRY_DELTA;
+      size_t len = encodeTelemetryHistory(since, mode, telemetryBuffer, sizeof(telemetryBuffer));
+      server.send_P(200, TELEMETRY_CONTENT_TYPE, (const char*)telemetryBuffer, len);
+    } else {
+      server.send(200, "application/json", getTelemetryHistoryJSON(since));
+    }
+  });
+
+  // Statistik diagnostik per sensor + bitmask fault aktif
+  server.on("/api/diagnostics", HTTP_GET, []() {
+    server.send(200, "application/json", getDiagnosticsJSON());
+  });
+
+  // Rollup jangka panjang: ?metric=temp|tds&from=<epoch>&to=<epoch>&points=<n>
+  // (default 24 jam terakhir, 300 titik)
+  server.on("/api/rollup", HTTP_GET, []() {
+    RollupMetric metric;
+    if (!parseRollupMetric(server.hasArg("metric") ? server.arg("metric") : String("temp"), metric)) {
+      server.send(400, "application/json", "{\"error\":\"Unknown metric\"}");
+      return;
+    }
+    uint32_t to = server.hasArg("to") ? strtoul(server.arg("to").c_str(), NULL, 10) : getRTCEpoch();
+    uint32_t from = server.hasArg("from") ? strtoul(server.arg("from").c_str(), NULL, 10) : (to > 86400 ? to - 86400 : 0);
+    int points = server.hasArg("points") ? server.arg("points").toInt() : 300;
+    server.send(200, "application/json", getRollupJSON(metric, from, to, points));
+  });
+
+  server.on("/api/energy", HTTP_GET, []() {
+    server.send(200, "application/json", getEnergyJSON());
+  });
+
+  server.on("/api/sampling", HTTP_GET, []() {
+    server.send(200, "application/json", getSamplingJSON());
+  });
+
+  // Setting runtime: GET untuk membaca, POST (form/query) untuk mengubah.
+  // Semua field divalidasi dulu; update diterapkan utuh di awal tick berikutnya.
+  server.on("/api/settings", HTTP_GET, []() {
+    server.send(200, "application/json", getSettingsJSON());
+  });
+
+  server.on("/api/settings", HTTP_POST, []() {
+    RuntimeSettings updated = getLatestSettings();
+    String error;
+    for (int i = 0; i < server.args(); i++) {
+      if (server.argName(i) == "plain") continue; // Body mentah, bukan field
+      if (!setSettingByName(updated, server.argName(i), server.arg(i), error)) {
+        server.send(400, "application/json", "{\"error\":\"" + error + "\"}");
+        return;
+      }
+    }
+    stageSettings(updated);
+    server.send(202, "application/json", "{\"status\":\"staged\"}");
+  });
+
+  // Trace recorder: rekam input mentah + keputusan aktuator untuk replay di host
+  server.on("/api/trace/start", HTTP_POST, []() {
+    startTraceRecording();
+    server.send(200, "application/json", "{\"recording\":true}");
+  });
 
+  server.on("/api/trace/stop", HTTP_POST, []() {
+    stopTraceRecording();
+    server.send(200, "application/json", "{\"recording\":false,\"bytes\":" + String((unsigned long)getTraceSize()) + "}");
+  });
+
+  server.on("/api/trace", HTTP_GET, []() {
+    if (isTraceRecording()) {
+      server.send(409, "text/plain", "Stop recording first");
+      return;
+    }
+    server.setContentLength(getTraceSize());
+    server.sendHeader("Content-Disposition", "attachment; filename=\"trace.bin\"");
+    server.send(200, "application/octet-stream", "");
+    writeTrace(server.client());
+  });
+
+  server.on("/api/boot", HTTP_GET, []() {
+    server.send(200, "application/json", getBootProfileJSON());
+  });
+}
+
+void printFilesystemDiagnostics() {
   // List files in SPIFFS
   File root = SPIFFS.open("/");
   File file = root.openNextFile();
@@ -40,30 +186,74 @@ void setup() {
   } else {
     Serial.println("[ERROR] Could not open /index.html");
   }
+}
+
+// Bagian boot yang tidak dibutuhkan kontrol, berjalan di core 0 paralel dengan loop()
+void bootDeferredTask(void* param) {
+  // Mount SPIFFS (format hanya di profil debug). Jika gagal, API tetap jalan.
+  if (!SPIFFS.begin(BOOT_PROFILE_DEBUG)) {
+    Serial.println("[ERROR] Failed to mount SPIFFS");
+  } else {
+    markBootPhase(BOOT_FS_MOUNTED);
+    Serial.println("[INFO] SPIFFS mounted");
+    setRollupStorageReady(); // Tier dimuat oleh serviceRollupStore() di loop()
+  }
 
   // Start SoftAP
   WiFi.softAP(ssid);
+  markBootPhase(BOOT_WIFI_READY);
   Serial.println("[INFO] SoftAP started");
   Serial.print("[INFO] IP Address: ");
   Serial.println(WiFi.softAPIP());
 
-  // Serve index.html on root
-  server.on("/", HTTP_GET, []() {
-    File file = SPIFFS.open("/index.html", "r");
-    if (!file) {
-      Serial.println("[ERROR] /index.html not found");
-      server.send(404, "text/plain", "File not found");
-      return;
-    }
-    Serial.println("[INFO] Serving /index.html");
-    server.streamFile(file, "text/html");
-    file.close();
-  });
-
+  setupRoutes();
+  const char* collectedHeaders[] = { "Accept", "If-None-Match" };
+  server.collectHeaders(collectedHeaders, 2);
   server.begin();
+  webReady = true;
+  markBootPhase(BOOT_WEB_READY);
   Serial.println("[INFO] Web server started");
+
+  initRTC();
+  markBootPhase(BOOT_RTC_READY);
+
+#if BOOT_PROFILE_DEBUG
+  printFilesystemDiagnostics();
+#endif
+
+  printBootProfile();
+  vTaskDelete(NULL);
+}
+
+void setup() {
+  markBootPhase(BOOT_START);
+  Serial.begin(115200);
+
+  // Aktuator ke kondisi aman sebelum apa pun
+  initDigitalPins();
+  markBootPhase(BOOT_OUTPUTS_SAFE);
+
+  initSettings();
+  initEnergyAccounting();
+  markBootPhase(BOOT_SETTINGS_LOADED);
+  initSensors();
+  markBootPhase(BOOT_SENSORS_READY);
+  initSystem();
+  markBootPhase(BOOT_CONTROL_READY); // tick() pertama berjalan begitu setup() selesai
+
+  Serial.println("[SETUP] Control ready, starting filesystem/WiFi in background...");
+  xTaskCreatePinnedToCore(bootDeferredTask, "bootDeferred", 8192, NULL, 1, NULL, 0);
 }
 
 void loop() {
-  server.handleClient();
+  if (millis() - lastTickTime >= CONTROL_TICK_MS) {
+    lastTickTime = millis();
+    tick();
+  }
+  if (webReady) {
+    server.handleClient();
+  }
+  serviceSettingsStore();
+  serviceEnergyStore();
+  serviceRollupStore();
 }
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include "response_cache.h"
+#include "system_manager.h"
+#include "sensor_reader.h"
+#include "telemetry.h"
+#include <Arduino.h>
+
+// Isi snapshot yang mempengaruhi body response. Kedua body diserialisasi
+// hanya dari struct ini, jadi JSON dan biner untuk satu seq selalu sama isinya.
+struct StatusSnapshot {
+  TelemetrySample sample;     // Nilai sensor sesuai presisi JSON/biner
+  uint8_t processMask = 0;
+  int stage = 0;
+  int errorCode = 0;
+  unsigned long errorTime = 0;
+  String errorMessage;        // Disalin hanya saat snapshot berubah
+  uint32_t epoch = 0;         // Epoch RTC saat snapshot diambil (tidak dibandingkan)
+  uint32_t rtcMinute = 0;     // Field time/date berubah per menit
+};
+
+StatusSnapshot currentSnapshot;
+unsigned long snapshotSeq = 0;
+uint32_t cacheBootId = 0;     // Membedakan ETag antar boot (seq mulai dari 0 lagi)
+
+// Body cache
+String cachedJSON;
+unsigned long cachedJSONSeq = 0;
+uint8_t cachedBinary[TELEMETRY_HEADER_SIZE + TELEMETRY_SAMPLE_SIZE + TELEMETRY_STATUS_SIZE];
+size_t cachedBinaryLength = 0;
+unsigned long cachedBinarySeq = 0;
+
+bool sameSnapshot(const StatusSnapshot& a, const StatusSnapshot& b) {
+  return a.sample.tempCenti == b.sample.tempCenti &&
+         a.sample.flowCenti == b.sample.flowCenti &&
+         a.sample.tds == b.sample.tds &&
+         a.sample.flags == b.sample.flags &&
+         a.processMask == b.processMask &&
+         a.stage == b.stage &&
+         a.errorCode == b.errorCode &&
+         a.errorTime == b.errorTime &&
+         a.rtcMinute == b.rtcMinute;
+}
+
+void publishStatusSnapshot(unsigned long now) {
+  StatusSnapshot next;
+  captureTelemetrySample(next.sample, now);
+  next.processMask = getActiveProcessMask();
+  next.stage = getActiveStage();
+  const ProcessError* error = getLatestError();
+  if (error) {
+    next.errorCode = error->code;
+    next.errorTime = error->startTime;
+  }
+  next.epoch = getRTCEpoch();
+  next.rtcMinute = next.epoch / 60;
+
+  if (snapshotSeq != 0 && sameSnapshot(next, currentSnapshot)) return;
+  if (error) next.errorMessage = error->message;
+  currentSnapshot = next;
+  snapshotSeq++;
+}
+
+unsigned long getStatusSnapshotSeq() {
+  return snapshotSeq;
+}
+
+const String& getCachedStatusJSON() {
+  if (cachedJSONSeq == snapshotSeq && cachedJSON.length() > 0) return cachedJSON;
+
+  String json;
+  json.reserve(384);
+  const TelemetrySample& sample = currentSnapshot.sample;
+  bool rtcValid = sample.flags & TELEMETRY_FLAG_RTC_VALID;
+  uint32_t epoch = rtcValid ? currentSnapshot.epoch : 0;
+  json = "{\"seq\":" + String(snapshotSeq);
+  json += ",\"temp\":" + String(sample.tempCenti / 100.0, 2);
+  json += ",\"flowRate\":" + String(sample.flowCenti / 100.0, 2);
+  json += ",\"tds\":" + String((int)sample.tds);
+  json += ",\"float\":" + String((sample.flags & TELEMETRY_FLAG_FLOAT_LOW) ? 1 : 0);
+  json += ",\"flowSwitch\":" + String((sample.flags & TELEMETRY_FLAG_FLOW_SWITCH) ? 1 : 0);
+  json += ",\"time\":\"" + formatRTCTime(epoch) + "\"";
+  json += ",\"date\":\"" + formatRTCDate(epoch) + "\"";
+  json += ",\"rtcValid\":" + String(rtcValid ? "true" : "false");
+
+  const char* names[] = { "filling", "draining", "cooling", "circulation", "waterChange", "prefill" };
+  json += ",\"processes\":{";
+  for (int i = 0; i <= PROCESS_PREFILL; i++) {
+    if (i > 0) json += ",";
+    json += "\"" + String(names[i]) + "\":" + String((currentSnapshot.processMask & (1 << i)) ? "true" : "false");
+  }
+  json += "}";
+  json += ",\"stage\":" + String(currentSnapshot.stage);
+
+  json += ",\"error\":{\"code\":" + String(currentSnapshot.errorCode);
+  json += ",\"message\":\"" + currentSnapshot.errorMessage + "\"}";
+  json += "}";
+
+  cachedJSON = json;
+  cachedJSONSeq = snapshotSeq;
+  return cachedJSON;
+}
+
+const uint8_t* getCachedStatusBinary(size_t& length) {
+  if (cachedBinarySeq != snapshotSeq || cachedBinaryLength == 0) {
+    TelemetryStatus status;
+    status.processMask = currentSnapshot.processMask;
+    status.stage = (uint8_t)currentSnapshot.stage;
+    status.errorCode = (uint8_t)currentSnapshot.errorCode;
+    cachedBinaryLength = encodeTelemetryStatus(currentSnapshot.sample, status, currentSnapshot.epoch,
+                                               cachedBinary, sizeof(cachedBinary));
+    cachedBinarySeq = snapshotSeq;
+  }
+  length = cachedBinaryLength;
+  return cachedBinary;
+}
+
+String getStatusETag(bool binary) {
+  if (cacheBootId == 0) cacheBootId = (uint32_t)micros() | 1;
+  char etag[32];
+  snprintf(etag, sizeof(etag), "\"%lx-%lu%s\"", (unsigned long)cacheBootId, snapshotSeq, binary ? "b" : "");
+  return String(etag);
+}
@@ -0,0 +1,25 @@
+#ifndef RESPONSE_CACHE_H
+#define RESPONSE_CACHE_H
+
+#include <Arduino.h>
+
+// ==================== CACHE RESPONSE STATUS ====================
+// Snapshot status (sensor + proses) diterbitkan di akhir setiap tick().
+// Nomor urut (seq) hanya naik jika isi snapshot berubah. Body JSON dan biner
+// diserialisasi dari snapshot tersebut sekali per seq (saat pertama diminta) lalu
+// dikirim dari buffer yang sama ke semua klien; ETag = seq, sehingga polling tanpa
+// perubahan dijawab 304. Body biner = frame TELEMETRY_STATUS (sensor + proses + error).
+
+// Bandingkan status saat ini dengan snapshot terakhir. Dipanggil dari tick().
+void publishStatusSnapshot(unsigned long now);
+
+unsigned long getStatusSnapshotSeq();
+
+// Body cache untuk seq saat ini (tetap valid sampai snapshot berikutnya)
+const String& getCachedStatusJSON();
+const uint8_t* getCachedStatusBinary(size_t& length);
+
+// ETag untuk representasi JSON atau biner dari seq saat ini
+String getStatusETag(bool binary);
+
+#endif
@@ -0,0 +1,116 @@
+// ==================== TELEMETRI BINER ====================
+// Decoder untuk format dari telemetry.h (TELEMETRY_SCHEMA_VERSION 2).
+const TELEMETRY_CONTENT_TYPE = 'application/vnd.icebatch.telemetry';
+const TELEMETRY_SCHEMA_VERSION = 2;
+const TELEMETRY_HEADER_SIZE = 14;
+const TELEMETRY_DELTA = 1;
+const TELEMETRY_STATUS = 2;
+
+function decodeTelemetry(buffer) {
+  const view = new DataView(buffer);
+  if (view.byteLength < TELEMETRY_HEADER_SIZE || view.getUint8(0) !== 0x54) {
+    throw new Error('Bukan frame telemetri');
+  }
+  const version = view.getUint8(1);
+  if (version > TELEMETRY_SCHEMA_VERSION) {
+    throw new Error('Versi skema telemetri tidak didukung: ' + version);
+  }
+  const mode = view.getUint8(2);
+  const count = view.getUint16(4, true);
+  const epoch = view.getUint32(6, true);
+  const frameMillis = view.getUint32(10, true);
+
+  let pos = TELEMETRY_HEADER_SIZE;
+  const readVarint = () => {
+    let value = 0;
+    let shift = 0;
+    let b;
+    do {
+      b = view.getUint8(pos++);
+      value += (b & 0x7f) * Math.pow(2, shift);
+      shift += 7;
+    } while (b & 0x80);
+    return value;
+  };
+  const readZigzag = () => {
+    const u = readVarint();
+    return u % 2 ? -(u + 1) / 2 : u / 2;
+  };
+
+  const samples = [];
+  let prev = null;
+  for (let i = 0; i < count; i++) {
+    let raw;
+    if (mode === TELEMETRY_DELTA && prev) {
+      raw = {
+        timeMs: (prev.timeMs + readVarint()) >>> 0,
+        tempCenti: prev.tempCenti + readZigzag(),
+        flowCenti: prev.flowCenti + readZigzag(),
+        tds: prev.tds + readZigzag(),
+        flags: view.getUint8(pos++),
+      };
+    } else {
+      raw = {
+        timeMs: view.getUint32(pos, true),
+        tempCenti: view.getInt16(pos + 4, true),
+        flowCenti: view.getUint16(pos + 6, true),
+        tds: view.getInt16(pos + 8, true),
+        flags: view.getUint8(pos + 10),
+      };
+      pos += 11;
+    }
+    prev = raw;
+    samples.push({
+      timeMs: raw.timeMs,
+      // Waktu nyata hanya tersedia jika RTC valid saat frame dibuat
+      time: epoch ? new Date((epoch + ((raw.timeMs - frameMillis) | 0) / 1000) * 1000) : null,
+      temp: raw.tempCenti / 100,
+      flowRate: raw.flowCenti / 100,
+      tds: raw.tds,
+      float: (raw.flags & 0x01) !== 0,
+      flowSwitch: (raw.flags & 0x02) !== 0,
+      rtcValid: (raw.flags & 0x04) !== 0,
+    });
+  }
+  const frame = { version: version, epoch: epoch, samples: samples };
+  // Frame /api/status: status proses setelah sampel (sama dengan field JSON)
+  if (mode === TELEMETRY_STATUS) {
+    frame.processMask = view.getUint8(pos);
+    frame.stage = view.getUint8(pos + 1);
+    frame.errorCode = view.getUint8(pos + 2);
+  }
+  return frame;
+}
+
+// Ambil data dengan format biner; server tetap bisa membalas JSON
+async function fetchTelemetry(url) {
+  const response = await fetch(url, { headers: { Accept: TELEMETRY_CONTENT_TYPE } });
+  if (!response.ok) throw new Error('HTTP ' + response.status);
+  if ((response.headers.get('Content-Type') || '').indexOf(TELEMETRY_CONTENT_TYPE) === 0) {
+    return decodeTelemetry(await response.arrayBuffer());
+  }
+  return response.json();
+}
+
+// ==================== ROLLUP ====================
+// Grafik jangka panjang dari /api/rollup (tier dipilih oleh server)
+async function fetchRollup(metric, from, to, points) {
+  const params = new URLSearchParams({ metric: metric });
+  if (from !== undefined) params.set('from', from);
+  if (to !== undefined) params.set('to', to);
+  if (points !== undefined) params.set('points', points);
+  const response = await fetch('/api/rollup?' + params.toString());
+  if (!response.ok) throw new Error('HTTP ' + response.status);
+  const body = await response.json();
+  return {
+    metric: body.metric,
+    resolution: body.resolution,
+    points: body.points.map((p) => ({
+      time: new Date(p[0] * 1000),
+      min: p[1],
+      max: p[2],
+      mean: p[3],
+      count: p[4],
+    })),
+  };
+}
@@ -0,0 +1,216 @@
+#include "sensor_diagnostics.h"
+#include "digital_control.h"
+#include <Arduino.h>
+
+// Konstanta diagnostik (bisa disesuaikan)
+const unsigned long DIAG_WINDOW_MS = 60000;             // Konstanta waktu EWMA (1 menit)
+const unsigned long FLOAT_STUCK_MS = 20UL * 60000;      // Inlet terbuka 20 menit tanpa edge float
+const unsigned long VALVE_SETTLE_MS = 10000;            // Sisa aliran setelah valve ditutup
+const unsigned long PUMP_SETTLE_MS = 15000;             // Pompa berhenti berputar setelah dimatikan
+const unsigned long FLOW_FAULT_MS = 10000;              // Aliran tanpa valve selama ini = fault
+const float FLOW_NOISE_LPM = 0.5;                       // Di bawah ini dianggap tidak ada aliran
+const unsigned long TEMP_RESPONSE_MS = 15UL * 60000;    // Waktu kompresor ON sebelum suhu dicek
+const float TEMP_MIN_DROP = 0.5;                        // Penurunan suhu minimal (C)
+const unsigned long TDS_FAIL_MS = 60000;                // Nilai error TDS terus-menerus
+
+// Resolusi per sensor: perubahan lebih kecil dari ini dianggap noise
+const float TEMP_RESOLUTION = 0.0625;
+const float FLOW_RESOLUTION = 0.1;
+const float TDS_RESOLUTION = 5.0;
+
+AnalogStats tempStats;
+AnalogStats flowStats;
+AnalogStats tdsStats;
+DigitalStats floatStats;
+DigitalStats flowSwitchStats;
+
+// State aktuator yang dilihat diagnostik (untuk mendeteksi transisi)
+bool diagInletOpen = false;
+bool diagValvesClosed = false;
+bool diagPumpOff = false;
+bool diagCompressorOn = false;
+unsigned long inletOpenSince = 0;
+unsigned long valvesClosedSince = 0;
+unsigned long pumpOffSince = 0;
+unsigned long compressorOnSince = 0;
+float tempAtCompressorOn = 0;
+unsigned long flowWithoutValveSince = 0;
+
+uint8_t activeFaults = 0;
+
+// ==================== STATISTIK INKREMENTAL ====================
+
+// Bobot EWMA berbasis waktu, jadi interval sampling yang berubah tetap benar
+float diagAlpha(unsigned long dt) {
+  return (float)dt / (float)(DIAG_WINDOW_MS + dt);
+}
+
+void updateAnalogStats(AnalogStats& s, float value, bool valid, float resolution, unsigned long now) {
+  if (!valid) {
+    if (s.invalidSince == 0) s.invalidSince = now ? now : 1;
+    return;
+  }
+  s.invalidSince = 0;
+
+  if (!s.initialized) {
+    s.initialized = true;
+    s.mean = value;
+    s.variance = 0;
+    s.slopePerMin = 0;
+    s.lastValue = value;
+    s.lastSampleTime = now;
+    s.lastChangeTime = now;
+    return;
+  }
+
+  unsigned long dt = now - s.lastSampleTime;
+  if (dt == 0) return;
+  float alpha = diagAlpha(dt);
+
+  float diff = value - s.mean;
+  s.mean += alpha * diff;
+  s.variance = (1.0 - alpha) * (s.variance + alpha * diff * diff);
+  float slope = (value - s.lastValue) * 60000.0 / dt;
+  s.slopePerMin += alpha * (slope - s.slopePerMin);
+
+  if (fabs(value - s.lastValue) >= resolution) s.lastChangeTime = now;
+  s.lastValue = value;
+  s.lastSampleTime = now;
+}
+
+void updateDigitalStats(DigitalStats& s, bool level, unsigned long now) {
+  if (!s.initialized) {
+    s.initialized = true;
+    s.level = level;
+    s.lastEdgeTime = now;
+    s.lastSampleTime = now;
+    return;
+  }
+
+  unsigned long dt = now - s.lastSampleTime;
+  if (dt == 0) return;
+  bool edge = level != s.level;
+  float instant = edge ? 60000.0 / dt : 0.0;
+  s.edgesPerMin += diagAlpha(dt) * (instant - s.edgesPerMin);
+
+  if (edge) {
+    s.level = level;
+    s.lastEdgeTime = now;
+    s.edgeCount++;
+  }
+  s.lastSampleTime = now;
+}
+
+void updateTemperatureStats(float value, unsigned long now) {
+  updateAnalogStats(tempStats, value, value != -99.0, TEMP_RESOLUTION, now);
+}
+
+void updateFlowStats(float value, unsigned long now) {
+  updateAnalogStats(flowStats, value, true, FLOW_RESOLUTION, now);
+}
+
+void updateTDSStats(float value, unsigned long now) {
+  updateAnalogStats(tdsStats, value, value >= 0, TDS_RESOLUTION, now);
+}
+
+void updateDigitalInputStats(bool floatLow, bool flowSwitchOn, unsigned long now) {
+  updateDigitalStats(floatStats, floatLow, now);
+  updateDigitalStats(flowSwitchStats, flowSwitchOn, now);
+}
+
+// ==================== CEK SILANG ====================
+
+uint8_t runSensorDiagnostics(unsigned long now) {
+  // Catat kapan state aktuator terakhir berubah
+  bool inletOpen = isValveInletOpen();
+  if (inletOpen && !diagInletOpen) inletOpenSince = now;
+  diagInletOpen = inletOpen;
+
+  bool valvesClosed = !inletOpen && !isValveDrainOpen();
+  if (valvesClosed && !diagValvesClosed) valvesClosedSince = now;
+  diagValvesClosed = valvesClosed;
+
+  // Pompa UV tetap jalan saat cooling dengan valve tertutup; sirkulasinya bisa
+  // melewati flow sensor, jadi pompa juga harus mati sebelum aliran dianggap janggal
+  bool pumpOff = !isPumpUVOn();
+  if (pumpOff && !diagPumpOff) pumpOffSince = now;
+  diagPumpOff = pumpOff;
+
+  bool compressorOn = isCompressorOn();
+  if (compressorOn && !diagCompressorOn) {
+    compressorOnSince = now;
+    tempAtCompressorOn = tempStats.lastValue;
+  }
+  diagCompressorOn = compressorOn;
+
+  uint8_t faults = 0;
+
+  // Float tidak pernah berubah selama inlet terbuka lama
+  if (inletOpen && now - inletOpenSince >= FLOAT_STUCK_MS &&
+      (long)(floatStats.lastEdgeTime - inletOpenSince) <= 0) {
+    faults |= DIAG_FLOAT_STUCK;
+  }
+
+  // Flow sensor membaca aliran padahal semua valve tertutup dan pompa mati
+  bool flowing = flowStats.initialized && flowStats.lastValue > FLOW_NOISE_LPM;
+  bool waterIdle = valvesClosed && now - valvesClosedSince >= VALVE_SETTLE_MS &&
+                   pumpOff && now - pumpOffSince >= PUMP_SETTLE_MS;
+  if (waterIdle && flowing) {
+    if (flowWithoutValveSince == 0) flowWithoutValveSince = now;
+    if (now - flowWithoutValveSince >= FLOW_FAULT_MS) faults |= DIAG_FLOW_WITHOUT_VALVE;
+  } else {
+    flowWithoutValveSince = 0;
+  }
+
+  // Suhu tidak turun walaupun kompresor menyala lama
+  if (compressorOn && tempStats.initialized && now - compressorOnSince >= TEMP_RESPONSE_MS &&
+      tempAtCompressorOn - tempStats.mean < TEMP_MIN_DROP) {
+    faults |= DIAG_TEMP_NOT_RESPONDING;
+  }
+
+  // Sensor TDS terus error
+  if (tdsStats.invalidSince != 0 && now - tdsStats.invalidSince >= TDS_FAIL_MS) {
+    faults |= DIAG_TDS_READ_FAILED;
+  }
+
+  activeFaults = faults;
+  return faults;
+}
+
+// ==================== JSON ====================
+
+void appendAnalogStatsJSON(String& json, const char* name, const AnalogStats& s, unsigned long now) {
+  json += "\"" + String(name) + "\":{";
+  json += "\"mean\":" + String(s.mean, 2);
+  json += ",\"std\":" + String(sqrt(s.variance), 3);
+  json += ",\"slopePerMin\":" + String(s.slopePerMin, 3);
+  json += ",\"sinceChangeMs\":" + String(s.initialized ? now - s.lastChangeTime : 0UL);
+  json += ",\"invalidMs\":" + String(s.invalidSince ? now - s.invalidSince : 0UL);
+  json += "}";
+}
+
+void appendDigitalStatsJSON(String& json, const char* name, const DigitalStats& s, unsigned long now) {
+  json += "\"" + String(name) + "\":{";
+  json += "\"level\":" + String(s.level ? "true" : "false");
+  json += ",\"sinceEdgeMs\":" + String(s.initialized ? now - s.lastEdgeTime : 0UL);
+  json += ",\"edgesPerMin\":" + String(s.edgesPerMin, 2);
+  json += ",\"edges\":" + String(s.edgeCount);
+  json += "}";
+}
+
+String getDiagnosticsJSON() {
+  unsigned long now = millis();
+  String json = "{";
+  appendAnalogStatsJSON(json, "temp", tempStats, now);
+  json += ",";
+  appendAnalogStatsJSON(json, "flowRate", flowStats, now);
+  json += ",";
+  appendAnalogStatsJSON(json, "tds", tdsStats, now);
+  json += ",";
+  appendDigitalStatsJSON(json, "float", floatStats, now);
+  json += ",";
+  appendDigitalStatsJSON(json, "flowSwitch", flowSwitchStats, now);
+  json += ",\"faults\":" + String((int)activeFaults);
+  json += "}";
+  return json;
+}
@@ -0,0 +1,51 @@
+#ifndef SENSOR_DIAGNOSTICS_H
+#define SENSOR_DIAGNOSTICS_H
+
+#include <Arduino.h>
+
+// ==================== DIAGNOSTIK SENSOR ====================
+// Statistik berjendela (EWMA) per input, diperbarui O(1) per sampel tanpa
+// menyimpan riwayat, lalu dicek silang dengan state aktuator.
+// Hasilnya bitmask kondisi fault; system_manager yang meneruskannya ke
+// jalur error proses (setError).
+
+// Bit kondisi fault
+#define DIAG_FLOAT_STUCK          0x01  // Inlet terbuka lama, float tidak pernah berubah
+#define DIAG_FLOW_WITHOUT_VALVE   0x02  // Ada pulsa flow padahal inlet & drain tertutup dan pompa UV mati
+#define DIAG_TEMP_NOT_RESPONDING  0x04  // Kompresor ON lama, suhu tidak turun
+#define DIAG_TDS_READ_FAILED      0x08  // Sensor TDS terus mengembalikan nilai error
+
+struct AnalogStats {
+  bool initialized = false;
+  float mean = 0;                  // Rata-rata EWMA
+  float variance = 0;              // Varians EWMA
+  float slopePerMin = 0;           // Laju perubahan EWMA (unit/menit)
+  float lastValue = 0;
+  unsigned long lastSampleTime = 0;
+  unsigned long lastChangeTime = 0; // Terakhir nilai bergerak melewati resolusi sensor
+  unsigned long invalidSince = 0;   // 0 = valid
+};
+
+struct DigitalStats {
+  bool initialized = false;
+  bool level = false;
+  unsigned long lastEdgeTime = 0;
+  unsigned long lastSampleTime = 0;
+  float edgesPerMin = 0;           // Laju edge EWMA (deteksi chatter)
+  unsigned long edgeCount = 0;
+};
+
+// Perbarui statistik satu sampel (dipanggil saat sensor dibaca)
+void updateTemperatureStats(float value, unsigned long now);
+void updateFlowStats(float value, unsigned long now);
+void updateTDSStats(float value, unsigned long now);
+void updateDigitalInputStats(bool floatLow, bool flowSwitchOn, unsigned long now);
+
+// Cek silang sensor dengan aktuator. Dipanggil tiap tick().
+// Mengembalikan bitmask DIAG_* yang sedang terdeteksi.
+uint8_t runSensorDiagnostics(unsigned long now);
+
+// Fungsi untuk mendapatkan statistik dalam format JSON
+String getDiagnosticsJSON();
+
+#endif
@@ -1,6 +1,12 @@
 #include "sensor_reader.h"
 #include "digital_control.h" // <-- Tambahkan ini untuk mengakses fungsi dari digital_control
 #include "pins.h"
+#include "trace_recorder.h"
+#include "settings_store.h" // Kalibrasi flow dan koefisien TDS
+#include "sensor_diagnostics.h"
+#include "energy_accounting.h"
+#include "sensor_rollup.h"
+#include "system_manager.h" // getActiveProcessMask() untuk kelas laju sampling
 #include <Arduino.h>
 #include <OneWire.h>
 #include <DallasTemperature.h>
@@ -10,8 +16,7 @@
 // Objek RTC
 RTC_DS3231 rtc;
 
-// Konstanta dari kode lama
-const float FS300A_CALIBRATION = 660.0; // Pulses per liter untuk FS300A
+// Konstanta dari kode lama (kalibrasi FS300A ada di settings.flowCalibration)
 const int FLOW_MAX_RATE = 60;          // Maksimal 60 L/min
 const int FLOW_SAMPLES = 5;            // Jumlah sampel untuk filter
 const int DEBOUNCE_TIME = 2;           // 2ms debounce time
@@ -20,13 +25,44 @@ const int DEBOUNCE_TIME = 2;           // 2ms debounce time
 OneWire oneWire(TEMP_SENSOR_PIN);
 DallasTemperature sensors(&oneWire);
 
-// Variabel global untuk menyimpan nilai sensor
-float currentTemp = 0.0;
-float currentFlowRate = 0.0;
-float currentTDS = 0.0;
+// Snapshot bersama: nilai terakhir tiap channel + waktu sampelnya
+SensorSnapshot snapshot;
 
-// Variabel RTC
-bool rtcValid = false;
+// ==================== KELAS LAJU SAMPLING ====================
+// Setiap channel punya periode idle dan periode aktif; periode aktif dipakai
+// jika salah satu proses di activeProcesses sedang berjalan.
+struct SamplingChannel {
+  const char* name;
+  unsigned long idlePeriodMs;
+  unsigned long activePeriodMs;
+  uint8_t activeProcesses;        // Bit (1 << PROCESS_TYPE)
+  unsigned long periodMs;         // Periode yang berlaku saat ini
+  bool started;
+  unsigned long lastStartTime;    // Awal sampel terakhir (dasar jadwal)
+  unsigned long lastPublishTime;  // Waktu hasil terakhir diterbitkan
+  unsigned long sampleCount;
+  float avgIntervalMs;            // EWMA interval antar sampel (laju aktual)
+};
+
+const uint8_t WATER_MOVING_PROCESSES = (1 << PROCESS_FILLING) | (1 << PROCESS_DRAINING) |
+                                       (1 << PROCESS_WATER_CHANGE) | (1 << PROCESS_PREFILL);
+
+SamplingChannel samplingChannels[SENSOR_CHANNEL_COUNT] = {
+  { "temp",    5000,  1000, (1 << PROCESS_COOLING) | (1 << PROCESS_CIRCULATION) },
+  { "flow",    2000,   500, WATER_MOVING_PROCESSES },
+  { "tds",    30000,  2000, (1 << PROCESS_WATER_CHANGE) },
+  { "digital", 1000,   100, WATER_MOVING_PROCESSES },
+};
+
+// Konversi suhu asinkron
+bool tempConversionPending = false;
+unsigned long tempConversionMs = 750;
+
+// Variabel RTC (diset oleh initRTC() dari task boot, dibaca oleh handler web)
+volatile bool rtcValid = false;
+const unsigned long RTC_RESYNC_INTERVAL_MS = 600000; // Sinkron ulang dari RTC tiap 10 menit
+uint32_t rtcEpochBase = 0;
+unsigned long rtcMillisBase = 0;
 
 // Variabel flow sensor
 volatile unsigned long pulseCount = 0;
@@ -49,10 +85,26 @@ void initSensors() {
   // Inisialisasi pin sensor digital dilakukan di digital_control.cpp
   // Kita asumsikan initDigitalPins() dipanggil sebelum initSensors()
 
-  // Inisialisasi sensor suhu
+  // Inisialisasi sensor suhu (konversi asinkron, lihat sampleTemperature())
   sensors.begin();
+  sensors.setWaitForConversion(false);
+  tempConversionMs = sensors.millisToWaitForConversion(sensors.getResolution());
+
+  // RTC tidak dibutuhkan oleh kontrol: probe I2C dilakukan terpisah lewat initRTC()
+
+  // Inisialisasi array filter flow rate
+  for (int i = 0; i < FLOW_SAMPLES; i++) {
+    flowReadings[i] = 0;
+  }
 
-  // Inisialisasi RTC
+  // Inisialisasi interrupt flow sensor
+  attachInterrupt(digitalPinToInterrupt(FLOW_SENSOR_PIN), flowISR, RISING);
+  resetSamplingSchedule(millis());
+
+  Serial.println("Sensors initialized.");
+}
+
+void initRTC() {
   Wire.begin(RTC_SDA_PIN, RTC_SCL_PIN); // Gunakan pin dari pins.h
   if (!rtc.begin()) {
     Serial.println("Tidak dapat menemukan RTC!");
@@ -68,114 +120,240 @@ void initSensors() {
       Serial.println("RTC initialized and valid.");
     }
   }
+}
 
-  // Inisialisasi array filter flow rate
-  for (int i = 0; i < FLOW_SAMPLES; i++) {
-    flowReadings[i] = 0;
-  }
-
-  // Inisialisasi interrupt flow sensor
-  attachInterrupt(digitalPinToInterrupt(FLOW_SENSOR_PIN), flowISR, RISING);
+// ==================== SAMPLING SCHEDULER ====================
 
-  Serial.println("Sensors initialized.");
+// Jadwal per channel: startChannel() saat sampel dimulai, publishChannel() saat
+// nilai masuk snapshot (untuk suhu keduanya terpisah oleh waktu konversi)
+bool channelDue(SensorChannel channel, unsigned long now) {
+  const SamplingChannel& ch = samplingChannels[channel];
+  return !ch.started || now - ch.lastStartTime >= ch.periodMs;
 }
 
-void readSensors() {
-  // ================= TEMPERATURE SENSOR =================
-  sensors.requestTemperatures();
-  currentTemp = sensors.getTempCByIndex(0);
+void startChannel(SensorChannel channel, unsigned long now) {
+  samplingChannels[channel].started = true;
+  samplingChannels[channel].lastStartTime = now;
+}
 
-  // Handle DS18B20 error codes
-  if (currentTemp == -127.00 || currentTemp == 85.00) {
-    currentTemp = -99.0; // Error indicator
+void publishChannel(SensorChannel channel, unsigned long now) {
+  SamplingChannel& ch = samplingChannels[channel];
+  if (ch.sampleCount > 0) {
+    float interval = (float)(now - ch.lastPublishTime);
+    ch.avgIntervalMs = ch.sampleCount == 1 ? interval : ch.avgIntervalMs + 0.2 * (interval - ch.avgIntervalMs);
   }
+  ch.lastPublishTime = now;
+  ch.sampleCount++;
+}
 
-  // ================= FLOW SENSOR (FS300A) =================
-  unsigned long currentTime = millis();
-  if (currentTime - lastFlowCalcTime >= 500) {  // Update setiap 500ms
-    noInterrupts();
-    unsigned long pulses = pulseCount - lastPulseCount;
-    lastPulseCount = pulseCount;
-    interrupts();
+void sampleTemperature(unsigned long now) {
+  // Konversi DS18B20 asinkron: request di satu tick, baca hasilnya setelah
+  // waktu konversi lewat, tanpa memblok loop kontrol
+  if (tempConversionPending) {
+    if (now - samplingChannels[CH_TEMPERATURE].lastStartTime < tempConversionMs) return;
+    tempConversionPending = false;
 
-    if (pulses == 0) {
-      currentFlowRate = 0.0;
-    } else {
-      currentFlowRate = (pulses * 60.0) / FS300A_CALIBRATION;
-      if (currentFlowRate > FLOW_MAX_RATE) currentFlowRate = FLOW_MAX_RATE;
+    float temp = traceTemperature(sensors.getTempCByIndex(0));
+    // Handle DS18B20 error codes
+    if (temp == -127.00 || temp == 85.00) {
+      temp = -99.0; // Error indicator
     }
+    snapshot.temp = temp;
+    snapshot.tempTime = now;
+    publishChannel(CH_TEMPERATURE, now);
+    updateTemperatureStats(temp, now);
+    if (temp != -99.0) updateRollup(ROLLUP_TEMP, temp);
+    return;
+  }
+
+  if (!channelDue(CH_TEMPERATURE, now)) return;
+  sensors.requestTemperatures();
+  tempConversionPending = true;
+  startChannel(CH_TEMPERATURE, now);
+}
 
-    lastFlowCalcTime = currentTime;
+void sampleFlow(unsigned long now) {
+  if (!channelDue(CH_FLOW, now)) return;
+
+  noInterrupts();
+  unsigned long pulses = pulseCount - lastPulseCount;
+  lastPulseCount = pulseCount;
+  unsigned long lastPulseMicros = lastInterruptTime;
+  interrupts();
+  pulses = traceFlowPulses(pulses, lastPulseMicros);
+  accountFlowPulses(pulses);
+
+  // Panjang jendela ikut periode channel
+  unsigned long window = now - lastFlowCalcTime;
+  if (pulses == 0 || window == 0) {
+    snapshot.flowRate = 0.0;
+  } else {
+    snapshot.flowRate = flowPulsesToLitres(pulses) * 60000.0 / window;
+    if (snapshot.flowRate > FLOW_MAX_RATE) snapshot.flowRate = FLOW_MAX_RATE;
   }
 
-  // ================= TDS SENSOR =================
-  int raw = analogRead(TDS_SENSOR_PIN);
+  lastFlowCalcTime = now;
+  startChannel(CH_FLOW, now);
+  snapshot.flowTime = now;
+  publishChannel(CH_FLOW, now);
+  updateFlowStats(snapshot.flowRate, now);
+}
+
+void sampleTDS(unsigned long now) {
+  if (!channelDue(CH_TDS, now)) return;
+  startChannel(CH_TDS, now);
+
+  int raw = traceAnalogInput(TDS_SENSOR_PIN, analogRead(TDS_SENSOR_PIN));
   float voltage = raw * (3.3 / 4095.0);
 
   // Validate TDS sensor
   if (raw < 100 || raw > 4000 || voltage < 0.1 || voltage > 3.2) {
-    currentTDS = -1; // Error indicator
+    snapshot.tds = -1; // Error indicator
   } else {
     // Calculate EC (Electrical Conductivity)
-    float ec = (133.42 * voltage * voltage * voltage
-               - 255.86 * voltage * voltage
-               + 857.39 * voltage);
+    float ec = (settings.tdsCoeffA * voltage * voltage * voltage
+               + settings.tdsCoeffB * voltage * voltage
+               + settings.tdsCoeffC * voltage);
     if (ec < 0) ec = 0;
     if (ec > 3000) ec = 3000;
-    currentTDS = ec * 0.5; // Convert to PPM
-    if (currentTDS > 9999) currentTDS = 9999;
+    snapshot.tds = ec * 0.5; // Convert to PPM
+    if (snapshot.tds > 9999) snapshot.tds = 9999;
   }
+  snapshot.tdsTime = now;
+  publishChannel(CH_TDS, now);
+  updateTDSStats(snapshot.tds, now);
+  if (snapshot.tds >= 0) updateRollup(ROLLUP_TDS, snapshot.tds);
+}
 
-  // NOTE: Pembacaan input digital (float, flow switch) tetap dilakukan
-  // di digital_control.cpp. Jika ingin disimpan di sini, Anda bisa
-  // memanggil fungsi dari digital_control.cpp di sini.
-  // Contoh:
-  // bool floatState = isFloatSensorLow(); // <-- Ini dari digital_control.cpp
-  // bool flowSwitchState = isFlowSwitchOn(); // <-- Ini dari digital_control.cpp
+void sampleDigitalInputs(unsigned long now) {
+  // Proses tetap membaca pin langsung saat butuh keputusan; channel ini
+  // menerbitkan nilai untuk snapshot, web dan diagnostik
+  if (!channelDue(CH_DIGITAL, now)) return;
+  startChannel(CH_DIGITAL, now);
+
+  snapshot.floatLow = isFloatSensorLow();
+  snapshot.flowSwitchOn = isFlowSwitchOn();
+  snapshot.digitalTime = now;
+  publishChannel(CH_DIGITAL, now);
+  updateDigitalInputStats(snapshot.floatLow, snapshot.flowSwitchOn, now);
 }
 
-String getSensorDataJSON() {
-  readSensors(); // Pastikan data terbaru
+void readSensors() {
+  unsigned long now = millis();
 
-  // Kita ambil nilai input digital dari digital_control
-  bool floatState = isFloatSensorLow();
-  bool flowSwitchState = isFlowSwitchOn();
+  // Pilih periode tiap channel sesuai proses yang sedang aktif
+  uint8_t processes = getActiveProcessMask();
+  for (int i = 0; i < SENSOR_CHANNEL_COUNT; i++) {
+    SamplingChannel& ch = samplingChannels[i];
+    ch.periodMs = (processes & ch.activeProcesses) ? ch.activePeriodMs : ch.idlePeriodMs;
+  }
 
+  // Hanya channel yang jatuh tempo yang menyentuh bus/ADC
+  sampleTemperature(now);
+  sampleFlow(now);
+  sampleTDS(now);
+  sampleDigitalInputs(now);
+}
+
+void resetSamplingSchedule(unsigned long now) {
+  // Semua channel jatuh tempo di tick berikutnya, konversi suhu yang
+  // sedang berjalan diabaikan, jendela flow dimulai dari sekarang
+  for (int i = 0; i < SENSOR_CHANNEL_COUNT; i++) {
+    samplingChannels[i].started = false;
+  }
+  tempConversionPending = false;
+
+  noInterrupts();
+  lastPulseCount = pulseCount;
+  interrupts();
+  lastFlowCalcTime = now;
+  startChannel(CH_FLOW, now);
+}
+
+String getSamplingJSON() {
+  unsigned long now = millis();
   String json = "{";
-  json += "\"temp\":" + String(currentTemp, 2);
-  json += ",\"flowRate\":" + String(currentFlowRate, 2);
-  json += ",\"tds\":" + String(currentTDS, 0);
-  json += ",\"float\":" + String(floatState);
-  json += ",\"flowSwitch\":" + String(flowSwitchState);
+  for (int i = 0; i < SENSOR_CHANNEL_COUNT; i++) {
+    const SamplingChannel& ch = samplingChannels[i];
+    if (i > 0) json += ",";
+    json += "\"" + String(ch.name) + "\":{";
+    json += "\"periodMs\":" + String(ch.periodMs);
+    json += ",\"achievedHz\":" + String(ch.avgIntervalMs > 0 ? 1000.0 / ch.avgIntervalMs : 0.0, 3);
+    json += ",\"samples\":" + String(ch.sampleCount);
+    json += ",\"ageMs\":" + String(ch.sampleCount ? now - ch.lastPublishTime : 0UL);
+    json += "}";
+  }
+  json += "}";
+  return json;
+}
+
+String getSensorDataJSON() {
+  String json = "{";
+  appendSensorDataJSON(json);
+  json += "}";
+  return json;
+}
+
+void appendSensorDataJSON(String& json) {
+  // Data diambil dari snapshot yang diperbarui oleh tick(); tidak membaca
+  // ulang di sini agar polling web tidak mengubah timing akuisisi kontrol
+  json += "\"temp\":" + String(snapshot.temp, 2);
+  json += ",\"flowRate\":" + String(snapshot.flowRate, 2);
+  json += ",\"tds\":" + String(snapshot.tds, 0);
+  json += ",\"float\":" + String(snapshot.floatLow);
+  json += ",\"flowSwitch\":" + String(snapshot.flowSwitchOn);
   json += ",\"time\":\"" + getRTCTime() + "\""; // Tambahkan waktu
   json += ",\"date\":\"" + getRTCDate() + "\""; // Tambahkan tanggal
   json += ",\"rtcValid\":" + String(isRTCValid() ? "true" : "false"); // Tambahkan status RTC
-  json += "}";
-  return json;
 }
 
 // Getter functions
-float getCurrentTemperature() { return currentTemp; }
-float getCurrentFlowRate() { return currentFlowRate; }
-float getCurrentTDS() { return currentTDS; }
+float getCurrentTemperature() { return snapshot.temp; }
+float getCurrentFlowRate() { return snapshot.flowRate; }
+float getCurrentTDS() { return snapshot.tds; }
+bool hasTemperatureSample() { return samplingChannels[CH_TEMPERATURE].sampleCount > 0; }
+const SensorSnapshot& getSensorSnapshot() { return snapshot; }
+
+float flowPulsesToLitres(unsigned long pulses) {
+  return pulses * 0.5 / settings.flowCalibration;
+}
 
 // Getter functions untuk RTC
 String getRTCTime() {
-  if (!rtcValid) return "ERR";
-  DateTime now = rtc.now();
+  return formatRTCTime(getRTCEpoch());
+}
+
+String getRTCDate() {
+  return formatRTCDate(getRTCEpoch());
+}
+
+String formatRTCTime(uint32_t epoch) {
+  if (epoch == 0) return "ERR";
+  DateTime now(epoch);
   char timeStr[6];
   sprintf(timeStr, "%02d:%02d", now.hour(), now.minute());
   return String(timeStr);
 }
 
-String getRTCDate() {
-  if (!rtcValid) return "ERR";
-  DateTime now = rtc.now();
+String formatRTCDate(uint32_t epoch) {
+  if (epoch == 0) return "ERR";
+  DateTime now(epoch);
   char dateStr[11];
   sprintf(dateStr, "%02d/%02d/%04d", now.day(), now.month(), now.year());
   return String(dateStr);
 }
 
+uint32_t getRTCEpoch() {
+  if (!rtcValid) return 0;
+  // Baca RTC lewat I2C hanya sesekali; di antaranya waktu dihitung dari millis()
+  unsigned long now = millis();
+  if (rtcEpochBase == 0 || now - rtcMillisBase >= RTC_RESYNC_INTERVAL_MS) {
+    rtcEpochBase = rtc.now().unixtime();
+    rtcMillisBase = now;
+  }
+  return rtcEpochBase + (now - rtcMillisBase) / 1000;
+}
+
 bool isRTCValid() {
   return rtcValid;
 }
\ No newline at end of file
@@ -3,23 +3,66 @@
 
 #include <Arduino.h>
 
-// Inisialisasi sensor
+// ==================== CHANNEL SAMPLING ====================
+// Setiap channel dibaca dengan periodenya sendiri (idle / saat proses terkait
+// aktif) oleh readSensors(), lalu diterbitkan ke snapshot bersama beserta waktunya.
+enum SensorChannel {
+  CH_TEMPERATURE = 0,  // DS18B20: 5 s idle, 1 s saat cooling/sirkulasi
+  CH_FLOW,             // Jendela pulsa: 2 s idle, 500 ms saat air bergerak
+  CH_TDS,              // ADC: 30 s idle, 2 s saat ganti air
+  CH_DIGITAL,          // Float + flow switch: 1 s idle, 100 ms saat air bergerak
+  SENSOR_CHANNEL_COUNT
+};
+
+struct SensorSnapshot {
+  float temp = 0.0;           // -99 = error
+  float flowRate = 0.0;       // L/min
+  float tds = 0.0;            // ppm, -1 = error
+  bool floatLow = false;
+  bool flowSwitchOn = false;
+  unsigned long tempTime = 0; // millis() saat tiap nilai disampel
+  unsigned long flowTime = 0;
+  unsigned long tdsTime = 0;
+  unsigned long digitalTime = 0;
+};
+
+// Inisialisasi sensor yang dibutuhkan kontrol (suhu, flow, TDS)
 void initSensors();
 
-// Fungsi baca sensor utama
+// Probe RTC lewat I2C (tidak dibutuhkan kontrol, boleh ditunda/dijalankan paralel)
+void initRTC();
+
+// Fungsi baca sensor utama: hanya channel yang jatuh tempo yang dibaca
 void readSensors();
 
+// Semua channel jatuh tempo lagi mulai now (titik sinkron untuk trace recorder)
+void resetSamplingSchedule(unsigned long now);
+
+// Periode berlaku, laju aktual dan umur sampel per channel (JSON)
+String getSamplingJSON();
+
 // Fungsi untuk mendapatkan data sensor dalam format JSON
 String getSensorDataJSON();
+void appendSensorDataJSON(String& json); // Field sensor tanpa kurung kurawal
 
 // Getter untuk masing-masing sensor
 float getCurrentTemperature();
 float getCurrentFlowRate();
 float getCurrentTDS();
+bool hasTemperatureSample(); // false sampai konversi suhu pertama selesai
+
+// Volume dari jumlah pulsa flow. Satu-satunya tempat settings.flowCalibration
+// ditafsirkan: nilai lama dikalibrasi untuk L/min = pulsa per 500 ms x 60 / kalibrasi,
+// jadi liter = pulsa x 0.5 / kalibrasi (kalibrasi = setengah pulsa per liter).
+float flowPulsesToLitres(unsigned long pulses);
+const SensorSnapshot& getSensorSnapshot();
 
 // Getter untuk RTC
 String getRTCTime(); // Format: "HH:MM"
 String getRTCDate(); // Format: "DD/MM/YYYY"
+String formatRTCTime(uint32_t epoch); // Seperti getRTCTime() untuk epoch tertentu, "ERR" jika 0
+String formatRTCDate(uint32_t epoch);
 bool isRTCValid();   // Cek apakah RTC menyimpan waktu yang valid
+uint32_t getRTCEpoch(); // Detik Unix, 0 jika RTC tidak valid
 
 #endif
\ No newline at end of file
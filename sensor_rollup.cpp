@@ -0,0 +1,352 @@
+#include "sensor_rollup.h"
+#include "sensor_reader.h" // getRTCEpoch()
+#include <Arduino.h>
+#include <SPIFFS.h>
+
+// Satu bucket per metrik; mean = sum / count (nilai terskala, lihat ROLLUP_SCALE)
+struct RollupBucket {
+  int16_t minValue;
+  int16_t maxValue;
+  int32_t sum;
+  uint16_t count;
+};
+
+struct RollupTier {
+  uint32_t resolutionSec;
+  uint16_t size;
+  uint32_t* slotIndex;                            // (epoch / resolusi) milik slot ini, 0 = kosong
+  RollupBucket* buckets[ROLLUP_METRIC_COUNT];
+};
+
+struct RollupFileHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t size;
+  uint32_t resolutionSec;
+  uint32_t metricCount;
+};
+
+const float ROLLUP_SCALE[ROLLUP_METRIC_COUNT] = { 100.0, 1.0 };
+const char* ROLLUP_METRIC_NAMES[ROLLUP_METRIC_COUNT] = { "temp", "tds" };
+
+// Tabel tetap: 1 jam @10 s, 6 jam @1 menit, 3 hari @15 menit, 14 hari @1 jam
+uint32_t rollupIndex10s[360];
+uint32_t rollupIndex1m[360];
+uint32_t rollupIndex15m[288];
+uint32_t rollupIndex1h[336];
+RollupBucket rollupBuckets10s[ROLLUP_METRIC_COUNT][360];
+RollupBucket rollupBuckets1m[ROLLUP_METRIC_COUNT][360];
+RollupBucket rollupBuckets15m[ROLLUP_METRIC_COUNT][288];
+RollupBucket rollupBuckets1h[ROLLUP_METRIC_COUNT][336];
+
+RollupTier rollupTiers[] = {
+  {   10, 360, rollupIndex10s, { rollupBuckets10s[ROLLUP_TEMP], rollupBuckets10s[ROLLUP_TDS] } },
+  {   60, 360, rollupIndex1m,  { rollupBuckets1m[ROLLUP_TEMP],  rollupBuckets1m[ROLLUP_TDS] } },
+  {  900, 288, rollupIndex15m, { rollupBuckets15m[ROLLUP_TEMP], rollupBuckets15m[ROLLUP_TDS] } },
+  { 3600, 336, rollupIndex1h,  { rollupBuckets1h[ROLLUP_TEMP],  rollupBuckets1h[ROLLUP_TDS] } },
+};
+const int ROLLUP_TIER_COUNT = sizeof(rollupTiers) / sizeof(rollupTiers[0]);
+
+// Persistensi (SPIFFS di-mount oleh task boot, tier diakses hanya dari loop())
+volatile bool rollupStorageReady = false;
+bool rollupLoaded = false;
+bool rollupDirty = false;
+int rollupSaveTier = -1;             // Tier berikutnya yang ditulis, -1 = tidak sedang menyimpan
+unsigned long lastRollupSaveTime = 0;
+
+// ==================== UPDATE ====================
+
+void updateRollup(RollupMetric metric, float value) {
+  uint32_t epoch = getRTCEpoch();
+  if (epoch == 0) return;
+
+  float scaled = value * ROLLUP_SCALE[metric];
+  if (scaled > 32767) scaled = 32767;
+  if (scaled < -32768) scaled = -32768;
+  int16_t v = (int16_t)lround(scaled);
+
+  for (int t = 0; t < ROLLUP_TIER_COUNT; t++) {
+    RollupTier& tier = rollupTiers[t];
+    uint32_t index = epoch / tier.resolutionSec;
+    uint16_t slot = index % tier.size;
+
+    // Slot berisi bucket lama (satu putaran tabel yang lalu): kosongkan untuk semua metrik
+    if (tier.slotIndex[slot] != index) {
+      tier.slotIndex[slot] = index;
+      for (int m = 0; m < ROLLUP_METRIC_COUNT; m++) {
+        tier.buckets[m][slot].count = 0;
+      }
+    }
+
+    RollupBucket& b = tier.buckets[metric][slot];
+    if (b.count == 0) {
+      b.minValue = v;
+      b.maxValue = v;
+      b.sum = 0;
+    } else {
+      if (v < b.minValue) b.minValue = v;
+      if (v > b.maxValue) b.maxValue = v;
+    }
+    if (b.count < 0xFFFF) {
+      b.sum += v;
+      b.count++;
+    }
+  }
+  rollupDirty = true;
+}
+
+// ==================== PERSISTENSI ====================
+
+String rollupFilePath(const RollupTier& tier) {
+  return "/rollup_" + String(tier.resolutionSec) + ".bin";
+}
+
+void clearRollupTier(RollupTier& tier) {
+  memset(tier.slotIndex, 0, tier.size * sizeof(uint32_t));
+}
+
+// Baca satu file tier; false jika tidak ada atau tidak valid (isi tier bisa sudah tertimpa)
+bool readRollupFile(RollupTier& tier, const String& path) {
+  File file = SPIFFS.open(path, "r");
+  if (!file) return false;
+
+  RollupFileHeader header;
+  bool ok = file.read((uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+            header.magic == ROLLUP_MAGIC && header.version == ROLLUP_VERSION &&
+            header.size == tier.size && header.resolutionSec == tier.resolutionSec &&
+            header.metricCount == ROLLUP_METRIC_COUNT;
+  if (ok) {
+    size_t len = tier.size * sizeof(uint32_t);
+    ok = file.read((uint8_t*)tier.slotIndex, len) == len;
+    for (int m = 0; ok && m < ROLLUP_METRIC_COUNT; m++) {
+      len = tier.size * sizeof(RollupBucket);
+      ok = file.read((uint8_t*)tier.buckets[m], len) == len;
+    }
+  }
+  file.close();
+  return ok;
+}
+
+void loadRollupTier(RollupTier& tier) {
+  String path = rollupFilePath(tier);
+  String tmpPath = path + ".tmp";
+  bool mainExists = SPIFFS.exists(path);
+  if (mainExists && readRollupFile(tier, path)) return;
+
+  // Daya putus di antara remove dan rename saat menyimpan: .tmp sudah lengkap
+  // (hanya di-rename setelah semua byte tertulis), selesaikan rename-nya
+  if (SPIFFS.exists(tmpPath) && readRollupFile(tier, tmpPath)) {
+    if (mainExists) SPIFFS.remove(path);
+    SPIFFS.rename(tmpPath, path);
+    Serial.println("Rollup: " + path + " dipulihkan dari .tmp.");
+    return;
+  }
+
+  clearRollupTier(tier);
+  if (mainExists) Serial.println("Rollup: File " + path + " tidak valid, diabaikan.");
+}
+
+bool saveRollupTier(const RollupTier& tier) {
+  // Tulis ke file sementara lalu ganti file lama. File lama utuh sampai .tmp
+  // lengkap; jika daya putus setelah remove, loadRollupTier() memakai .tmp
+  String path = rollupFilePath(tier);
+  String tmpPath = path + ".tmp";
+  File file = SPIFFS.open(tmpPath, "w");
+  if (!file) return false;
+
+  RollupFileHeader header;
+  header.magic = ROLLUP_MAGIC;
+  header.version = ROLLUP_VERSION;
+  header.size = tier.size;
+  header.resolutionSec = tier.resolutionSec;
+  header.metricCount = ROLLUP_METRIC_COUNT;
+
+  size_t expected = sizeof(header) + tier.size * sizeof(uint32_t);
+  size_t written = file.write((const uint8_t*)&header, sizeof(header));
+  written += file.write((const uint8_t*)tier.slotIndex, tier.size * sizeof(uint32_t));
+  for (int m = 0; m < ROLLUP_METRIC_COUNT; m++) {
+    expected += tier.size * sizeof(RollupBucket);
+    written += file.write((const uint8_t*)tier.buckets[m], tier.size * sizeof(RollupBucket));
+  }
+  file.close();
+
+  if (written != expected) {
+    SPIFFS.remove(tmpPath);
+    return false;
+  }
+  SPIFFS.remove(path);
+  return SPIFFS.rename(tmpPath, path);
+}
+
+void setRollupStorageReady() {
+  rollupStorageReady = true;
+}
+
+void serviceRollupStore() {
+  if (!rollupStorageReady) return;
+
+  // Muat sekali setelah SPIFFS siap. Sampel sebelum ini (hanya beberapa detik
+  // setelah RTC siap saat boot) tertimpa isi file.
+  if (!rollupLoaded) {
+    for (int t = 0; t < ROLLUP_TIER_COUNT; t++) {
+      loadRollupTier(rollupTiers[t]);
+    }
+    rollupLoaded = true;
+    lastRollupSaveTime = millis();
+    Serial.println("Rollup: Tier dimuat dari SPIFFS.");
+    return;
+  }
+
+  if (rollupSaveTier < 0) {
+    if (!rollupDirty || millis() - lastRollupSaveTime < ROLLUP_SAVE_INTERVAL_MS) return;
+    rollupDirty = false;
+    rollupSaveTier = 0;
+  }
+
+  // Satu tier per panggilan agar loop() tidak tertahan terlalu lama
+  if (!saveRollupTier(rollupTiers[rollupSaveTier])) {
+    rollupDirty = true; // Coba lagi di interval berikutnya
+    Serial.println("Rollup: Gagal menyimpan " + rollupFilePath(rollupTiers[rollupSaveTier]));
+  }
+  rollupSaveTier++;
+  if (rollupSaveTier >= ROLLUP_TIER_COUNT) {
+    rollupSaveTier = -1;
+    lastRollupSaveTime = millis();
+  }
+}
+
+// ==================== QUERY ====================
+
+bool parseRollupMetric(const String& name, RollupMetric& metric) {
+  for (int m = 0; m < ROLLUP_METRIC_COUNT; m++) {
+    if (name == ROLLUP_METRIC_NAMES[m]) {
+      metric = (RollupMetric)m;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Bucket tertua yang masih disimpan tier (indeks)
+uint32_t rollupOldestIndex(const RollupTier& tier, uint32_t now) {
+  uint32_t newest = now / tier.resolutionSec;
+  return newest >= tier.size ? newest - tier.size + 1 : 0;
+}
+
+// Tier mencakup rentang mulai `from`; bucket pertama yang baru sebagian
+// (misal "6 jam terakhir" di tier 6 jam) boleh sudah tertimpa
+bool rollupCovers(const RollupTier& tier, uint32_t from, uint32_t now) {
+  return from / tier.resolutionSec + 1 >= rollupOldestIndex(tier, now);
+}
+
+int selectRollupTier(uint32_t from, uint32_t to, int points, uint32_t now) {
+  uint32_t wantedRes = (to - from) / points;
+
+  // Tier paling kasar yang resolusinya cukup halus dan masih mencakup `from`
+  int best = -1;
+  for (int t = 0; t < ROLLUP_TIER_COUNT; t++) {
+    const RollupTier& tier = rollupTiers[t];
+    if (tier.resolutionSec <= wantedRes && rollupCovers(tier, from, now)) best = t;
+  }
+  if (best >= 0) return best;
+
+  // Rentang terlalu pendek untuk tier mana pun: tier paling halus yang mencakupnya;
+  // rentang lebih panjang dari retensi: tier paling kasar
+  for (int t = 0; t < ROLLUP_TIER_COUNT; t++) {
+    if (rollupCovers(rollupTiers[t], from, now)) return t;
+  }
+  return ROLLUP_TIER_COUNT - 1;
+}
+
+// Gabungan beberapa bucket (sum/count lebih lebar dari RollupBucket)
+struct RollupPoint {
+  int16_t minValue;
+  int16_t maxValue;
+  double sum;
+  uint32_t count;
+};
+
+void appendRollupPoint(String& json, bool& first, uint32_t time, const RollupPoint& p, float scale) {
+  if (!first) json += ",";
+  first = false;
+  int decimals = scale > 1.0 ? 2 : 0;
+  json += "[" + String(time);
+  json += "," + String(p.minValue / scale, decimals);
+  json += "," + String(p.maxValue / scale, decimals);
+  json += "," + String(p.sum / p.count / scale, decimals);
+  json += "," + String(p.count) + "]";
+}
+
+String getRollupJSON(RollupMetric metric, uint32_t from, uint32_t to, int points) {
+  uint32_t now = getRTCEpoch();
+  if (now == 0) now = to;
+  if (points < 1) points = 1;
+  if (points > ROLLUP_MAX_POINTS) points = ROLLUP_MAX_POINTS;
+  if (to < from) to = from;
+  if (to > now) to = now;
+
+  // Rentang di masa depan: belum ada bucket sama sekali
+  if (from > now) {
+    return "{\"metric\":\"" + String(ROLLUP_METRIC_NAMES[metric]) + "\",\"resolution\":0"
+           ",\"tierResolution\":0,\"from\":" + String(from) + ",\"to\":" + String(from) +
+           ",\"points\":[]}";
+  }
+
+  int t = selectRollupTier(from, to, points, now);
+  const RollupTier& tier = rollupTiers[t];
+  const RollupBucket* buckets = tier.buckets[metric];
+  float scale = ROLLUP_SCALE[metric];
+
+  // Batasi ke bucket yang masih ada di tabel (paling banyak tier.size iterasi)
+  uint32_t firstIndex = from / tier.resolutionSec;
+  uint32_t lastIndex = to / tier.resolutionSec;
+  uint32_t oldest = rollupOldestIndex(tier, now);
+  if (firstIndex < oldest) firstIndex = oldest;
+  uint32_t bucketCount = lastIndex >= firstIndex ? lastIndex - firstIndex + 1 : 0;
+
+  // Rentang inklusif sepanjang N x resolusi menyentuh N + 1 bucket (dua bucket
+  // tepi yang parsial), jadi gabungkan berdasarkan N agar tier yang dipilih
+  // selectRollupTier() tidak dibagi dua. Hasilnya paling banyak points + 1 titik.
+  uint32_t span = bucketCount > 0 ? bucketCount - 1 : 0;
+  uint32_t group = span > (uint32_t)points ? (span + points - 1) / points : 1;
+
+  String json;
+  json.reserve(64 + points * 32);
+  json = "{\"metric\":\"" + String(ROLLUP_METRIC_NAMES[metric]) + "\"";
+  json += ",\"resolution\":" + String(tier.resolutionSec * group);
+  json += ",\"tierResolution\":" + String(tier.resolutionSec);
+  json += ",\"from\":" + String(from);
+  json += ",\"to\":" + String(to);
+  json += ",\"points\":[";
+
+  bool first = true;
+  RollupPoint merged;
+  merged.count = 0;
+  uint32_t groupStart = firstIndex;
+  for (uint32_t i = 0; i < bucketCount; i++) {
+    uint32_t index = firstIndex + i;
+    uint16_t slot = index % tier.size;
+    if (tier.slotIndex[slot] == index && buckets[slot].count > 0) {
+      const RollupBucket& b = buckets[slot];
+      if (merged.count == 0) {
+        merged.minValue = b.minValue;
+        merged.maxValue = b.maxValue;
+        merged.sum = 0;
+      } else {
+        if (b.minValue < merged.minValue) merged.minValue = b.minValue;
+        if (b.maxValue > merged.maxValue) merged.maxValue = b.maxValue;
+      }
+      merged.sum += b.sum;
+      merged.count += b.count;
+    }
+    if ((i + 1) % group == 0 || i + 1 == bucketCount) {
+      if (merged.count > 0) {
+        appendRollupPoint(json, first, groupStart * tier.resolutionSec, merged, scale);
+      }
+      merged.count = 0;
+      groupStart = index + 1;
+    }
+  }
+  json += "]}";
+  return json;
+}
@@ -0,0 +1,42 @@
+#ifndef SENSOR_ROLLUP_H
+#define SENSOR_ROLLUP_H
+
+#include <Arduino.h>
+
+// ==================== ROLLUP MULTI-RESOLUSI ====================
+// Setiap sampel suhu/TDS dari sensor_reader masuk ke bucket min/max/mean/count
+// di empat tier (10 s, 1 menit, 15 menit, 1 jam). Tiap tier adalah tabel
+// melingkar berukuran tetap yang diindeks dengan (epoch RTC / resolusi), jadi
+// update per sampel O(1) dan memori tetap (~37 KB). Tanpa RTC valid sampel
+// tidak dimasukkan (timestamp tier harus absolut agar bisa dipersist).
+// Tier ditulis ke SPIFFS berkala, satu tier per panggilan serviceRollupStore().
+#define ROLLUP_MAGIC             0x55544349UL // "ICTU"
+#define ROLLUP_VERSION           1
+#define ROLLUP_SAVE_INTERVAL_MS  900000UL     // Simpan semua tier tiap 15 menit
+#define ROLLUP_MAX_POINTS        500          // Batas titik per query
+
+enum RollupMetric {
+  ROLLUP_TEMP = 0,   // C x 100
+  ROLLUP_TDS,        // ppm
+  ROLLUP_METRIC_COUNT
+};
+
+// Masukkan satu sampel valid. Dipanggil saat sensor menerbitkan nilai baru.
+void updateRollup(RollupMetric metric, float value);
+
+// Dipanggil dari task boot setelah SPIFFS ter-mount
+void setRollupStorageReady();
+
+// Muat tier (sekali) lalu simpan berkala. Dipanggil dari loop(), di luar tick().
+void serviceRollupStore();
+
+// Nama metrik dari query (?metric=temp|tds), false jika tidak dikenal
+bool parseRollupMetric(const String& name, RollupMetric& metric);
+
+// Bucket untuk rentang [from, to] (epoch detik) dari tier paling kasar yang
+// masih memberi minimal `points` titik dan mencakup rentangnya. Jika tier
+// tersebut punya lebih banyak bucket, bucket digabung sampai <= points (+1 untuk
+// bucket tepi yang parsial). `to` dibatasi ke waktu RTC sekarang.
+String getRollupJSON(RollupMetric metric, uint32_t from, uint32_t to, int points);
+
+#endif
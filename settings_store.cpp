@@ -0,0 +1,215 @@
+#include "settings_store.h"
+#include "trace_recorder.h"
+#include <Arduino.h>
+#include <Preferences.h>
+#include <stddef.h>
+#include <math.h>
+
+// Header blob di NVS (diikuti byte RuntimeSettings)
+struct SettingsBlobHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t size;      // sizeof(RuntimeSettings) saat blob ditulis
+  uint32_t checksum;  // Checksum byte setting
+};
+
+const char* SETTINGS_NAMESPACE = "icebatch";
+const char* SETTINGS_KEY = "settings";
+
+RuntimeSettings settings;
+
+// Update yang menunggu batas tick
+RuntimeSettings pendingSettings;
+bool settingsPending = false;
+
+// Write-behind
+bool settingsDirty = false;
+unsigned long settingsChangedTime = 0;
+
+// ==================== TABEL FIELD ====================
+enum SettingType {
+  SETTING_FLOAT,
+  SETTING_U32
+};
+
+struct SettingField {
+  const char* name;
+  SettingType type;
+  size_t offset;
+  float minValue;
+  float maxValue;
+};
+
+const SettingField SETTING_FIELDS[] = {
+  { "targetTemp",             SETTING_FLOAT, offsetof(RuntimeSettings, targetTemp),             -5.0,   30.0 },
+  { "tempHysteresis",         SETTING_FLOAT, offsetof(RuntimeSettings, tempHysteresis),          0.1,   10.0 },
+  { "flowRateThreshold",      SETTING_FLOAT, offsetof(RuntimeSettings, flowRateThreshold),       0.0,   10.0 },
+  { "fillingFloatDebounceMs", SETTING_U32,   offsetof(RuntimeSettings, fillingFloatDebounceMs),  0.0,   10000.0 },
+  { "preDrainMs",             SETTING_U32,   offsetof(RuntimeSettings, preDrainMs),              0.0,   60000.0 },
+  { "flowCalibration",        SETTING_FLOAT, offsetof(RuntimeSettings, flowCalibration),         1.0,   10000.0 },
+  { "tdsCoeffA",              SETTING_FLOAT, offsetof(RuntimeSettings, tdsCoeffA),          -10000.0,   10000.0 },
+  { "tdsCoeffB",              SETTING_FLOAT, offsetof(RuntimeSettings, tdsCoeffB),          -10000.0,   10000.0 },
+  { "tdsCoeffC",              SETTING_FLOAT, offsetof(RuntimeSettings, tdsCoeffC),          -10000.0,   10000.0 },
+  { "compressorPowerW",       SETTING_FLOAT, offsetof(RuntimeSettings, compressorPowerW),        0.0,   5000.0 },
+  { "pumpUVPowerW",           SETTING_FLOAT, offsetof(RuntimeSettings, pumpUVPowerW),            0.0,   1000.0 },
+  { "valvePowerW",            SETTING_FLOAT, offsetof(RuntimeSettings, valvePowerW),             0.0,   100.0 },
+};
+const int SETTING_FIELD_COUNT = sizeof(SETTING_FIELDS) / sizeof(SETTING_FIELDS[0]);
+
+// ==================== BLOB NVS ====================
+
+uint32_t settingsChecksum(const uint8_t* data, size_t len) {
+  // FNV-1a 32-bit
+  uint32_t hash = 2166136261UL;
+  for (size_t i = 0; i < len; i++) {
+    hash ^= data[i];
+    hash *= 16777619UL;
+  }
+  return hash;
+}
+
+void initSettings() {
+  settings = RuntimeSettings();
+
+  Preferences prefs;
+  if (!prefs.begin(SETTINGS_NAMESPACE, true)) {
+    Serial.println("Settings: NVS kosong, memakai default.");
+    return;
+  }
+
+  uint8_t blob[sizeof(SettingsBlobHeader) + sizeof(RuntimeSettings)];
+  size_t len = prefs.getBytes(SETTINGS_KEY, blob, sizeof(blob));
+  prefs.end();
+
+  SettingsBlobHeader header;
+  if (len < sizeof(header)) {
+    Serial.println("Settings: Belum tersimpan, memakai default.");
+    return;
+  }
+  memcpy(&header, blob, sizeof(header));
+
+  const uint8_t* payload = blob + sizeof(header);
+  if (header.magic != SETTINGS_MAGIC || header.version > SETTINGS_VERSION ||
+      header.size > sizeof(RuntimeSettings) || len < sizeof(header) + header.size ||
+      header.checksum != settingsChecksum(payload, header.size)) {
+    Serial.println("Settings: Blob tidak valid, memakai default.");
+    return;
+  }
+
+  // Blob versi lama lebih pendek: field baru tetap default
+  memcpy(&settings, payload, header.size);
+  Serial.println("Settings: Dimuat dari NVS (versi " + String(header.version) + ").");
+}
+
+bool writeSettingsBlob() {
+  uint8_t blob[sizeof(SettingsBlobHeader) + sizeof(RuntimeSettings)];
+  SettingsBlobHeader header;
+  header.magic = SETTINGS_MAGIC;
+  header.version = SETTINGS_VERSION;
+  header.size = sizeof(RuntimeSettings);
+  header.checksum = settingsChecksum((const uint8_t*)&settings, sizeof(RuntimeSettings));
+  memcpy(blob, &header, sizeof(header));
+  memcpy(blob + sizeof(header), &settings, sizeof(RuntimeSettings));
+
+  Preferences prefs;
+  if (!prefs.begin(SETTINGS_NAMESPACE, false)) return false;
+
+  // Lewati penulisan jika isi flash sudah sama (hemat siklus tulis)
+  uint8_t stored[sizeof(blob)];
+  size_t storedLen = prefs.getBytes(SETTINGS_KEY, stored, sizeof(stored));
+  bool ok = true;
+  if (storedLen != sizeof(blob) || memcmp(stored, blob, sizeof(blob)) != 0) {
+    ok = prefs.putBytes(SETTINGS_KEY, blob, sizeof(blob)) == sizeof(blob);
+  }
+  prefs.end();
+  return ok;
+}
+
+// ==================== UPDATE ====================
+
+void applyPendingSettings() {
+  if (!settingsPending) return;
+  settings = pendingSettings;
+  settingsPending = false;
+  settingsDirty = true;
+  settingsChangedTime = millis();
+  traceSettings((const uint8_t*)&settings, sizeof(settings));
+  Serial.println("Settings: Update diterapkan.");
+}
+
+void serviceSettingsStore() {
+  if (!settingsDirty) return;
+  // Coalescing: tunggu sampai tidak ada update selama SETTINGS_WRITE_DELAY_MS
+  if (millis() - settingsChangedTime < SETTINGS_WRITE_DELAY_MS) return;
+
+  if (writeSettingsBlob()) {
+    settingsDirty = false;
+    Serial.println("Settings: Disimpan ke NVS.");
+  } else {
+    settingsChangedTime = millis(); // Coba lagi nanti
+    Serial.println("Settings: Gagal menyimpan ke NVS.");
+  }
+}
+
+RuntimeSettings getLatestSettings() {
+  return settingsPending ? pendingSettings : settings;
+}
+
+bool setSettingByName(RuntimeSettings& target, const String& name, const String& value, String& error) {
+  for (int i = 0; i < SETTING_FIELD_COUNT; i++) {
+    const SettingField& field = SETTING_FIELDS[i];
+    if (name != field.name) continue;
+
+    // Pesan error hanya memakai field.name dari tabel, bukan input dari web
+    char* end = nullptr;
+    float parsed = strtof(value.c_str(), &end);
+    // strtof menerima "nan"/"inf"; NaN lolos cek range karena semua perbandingan false
+    if (end == value.c_str() || *end != '\0' || !isfinite(parsed)) {
+      error = "Invalid number for " + String(field.name);
+      return false;
+    }
+    if (field.type == SETTING_U32 && parsed != floorf(parsed)) {
+      error = String(field.name) + " must be an integer";
+      return false;
+    }
+    if (parsed < field.minValue || parsed > field.maxValue) {
+      error = String(field.name) + " out of range [" + String(field.minValue, 1) + ", " + String(field.maxValue, 1) + "]";
+      return false;
+    }
+
+    uint8_t* base = (uint8_t*)&target;
+    if (field.type == SETTING_FLOAT) {
+      *(float*)(base + field.offset) = parsed;
+    } else {
+      *(uint32_t*)(base + field.offset) = (uint32_t)parsed;
+    }
+    return true;
+  }
+  error = "Unknown setting"; // Nama dari web tidak disalin ke body JSON
+  return false;
+}
+
+void stageSettings(const RuntimeSettings& updated) {
+  // Diterapkan utuh di awal tick berikutnya, tidak pernah setengah jalan
+  pendingSettings = updated;
+  settingsPending = true;
+}
+
+String getSettingsJSON() {
+  const uint8_t* base = (const uint8_t*)&settings;
+  String json = "{";
+  for (int i = 0; i < SETTING_FIELD_COUNT; i++) {
+    const SettingField& field = SETTING_FIELDS[i];
+    if (i > 0) json += ",";
+    json += "\"" + String(field.name) + "\":";
+    if (field.type == SETTING_FLOAT) {
+      json += String(*(const float*)(base + field.offset), 2);
+    } else {
+      json += String((unsigned long)*(const uint32_t*)(base + field.offset));
+    }
+  }
+  json += ",\"pending\":" + String(settingsPending ? "true" : "false");
+  json += ",\"unsaved\":" + String(settingsDirty ? "true" : "false");
+  json += "}";
+  return json;
+}
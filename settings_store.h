@@ -0,0 +1,55 @@
+#ifndef SETTINGS_STORE_H
+#define SETTINGS_STORE_H
+
+#include <Arduino.h>
+
+// ==================== SETTING RUNTIME ====================
+// Blob biner berversi di NVS, dimuat sekali saat boot ke struct di RAM.
+// Hot path membaca field langsung dari `settings` (tidak pernah menyentuh flash).
+// Field baru SELALU ditambahkan di akhir struct dan SETTINGS_VERSION dinaikkan:
+// blob versi lama tetap dimuat (prefix), sisanya memakai nilai default.
+#define SETTINGS_MAGIC           0x53544349UL // "ICTS"
+#define SETTINGS_VERSION         2
+#define SETTINGS_WRITE_DELAY_MS  5000         // Write-behind: tunggu update lain sebelum tulis flash
+
+struct RuntimeSettings {
+  float targetTemp = 15.0;               // Target suhu cooling (C)
+  float tempHysteresis = 2.0;            // Histeresis kontrol suhu (C)
+  float flowRateThreshold = 0.1;         // L/min, di bawah ini dianggap tidak ada aliran untuk draining
+  uint32_t fillingFloatDebounceMs = 500; // Debounce float sensor saat penuh
+  uint32_t preDrainMs = 5000;            // Draining awal sebelum filling
+  float flowCalibration = 660.0;         // Setengah pulsa per liter (660 = 1320 pulsa/L), lihat flowPulsesToLitres()
+  float tdsCoeffA = 133.42;              // EC = A*v^3 + B*v^2 + C*v
+  float tdsCoeffB = -255.86;
+  float tdsCoeffC = 857.39;
+  // Versi 2: daya relay untuk estimasi energi (energy_accounting.h)
+  float compressorPowerW = 250.0;        // W saat kompresor menyala
+  float pumpUVPowerW = 40.0;             // W pompa + lampu UV
+  float valvePowerW = 6.0;               // W per solenoid valve
+};
+
+// Setting aktif (hanya diubah oleh applyPendingSettings() di batas tick)
+extern RuntimeSettings settings;
+
+// Muat setting dari NVS (atau default jika kosong/rusak)
+void initSettings();
+
+// Terapkan update yang menunggu secara atomik. Dipanggil di awal tick().
+void applyPendingSettings();
+
+// Tulis ke NVS jika ada perubahan yang sudah stabil. Dipanggil dari loop(), di luar tick().
+void serviceSettingsStore();
+
+// Update dari HTTP: ubah satu field di salinan, validasi, lalu jadwalkan
+RuntimeSettings getLatestSettings(); // Setting yang menunggu (jika ada) atau setting aktif
+// `error` tidak pernah memuat input dari web, aman disisipkan langsung ke JSON
+bool setSettingByName(RuntimeSettings& target, const String& name, const String& value, String& error);
+void stageSettings(const RuntimeSettings& updated);
+
+// Fungsi untuk mendapatkan setting dalam format JSON
+String getSettingsJSON();
+
+// Checksum FNV-1a untuk blob NVS (juga dipakai energy_accounting)
+uint32_t settingsChecksum(const uint8_t* data, size_t len);
+
+#endif
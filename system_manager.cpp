@@ -1,6 +1,12 @@
 #include "system_manager.h"
 #include "digital_control.h"
 #include "sensor_reader.h"
+#include "trace_recorder.h"
+#include "settings_store.h"
+#include "telemetry.h"
+#include "response_cache.h"
+#include "sensor_diagnostics.h"
+#include "energy_accounting.h"
 #include <Arduino.h>
 
 // ==================== DEKLARASI VARIABEL GLOBAL (INSTANCE STRUCT) ====================
@@ -11,11 +17,10 @@ CoolingState coolingState;
 CirculationState circulationState;
 WaterChangeState waterChangeState;
 PrefillState prefillState;
+ProcessError sensorFaultError; // Fault diagnostik yang tidak dimiliki proses aktif
 
-// Konstanta untuk sistem (bisa disesuaikan)
-const float FLOW_RATE_THRESHOLD = 0.1; // L/min, di bawah ini dianggap tidak ada aliran untuk draining
-const int FILLING_FLOAT_DEBOUNCE_MS = 500; // Waktu untuk menghindari false trigger saat float sensor penuh
-const float TEMP_HYSTERESIS = 2.0; // Histeresis untuk kontrol suhu (2 derajat)
+// Konstanta sistem (target suhu, histeresis, threshold, debounce, pre-drain)
+// sekarang ada di RuntimeSettings (settings_store.h) dan bisa diubah lewat web
 
 // ==================== IMPLEMENTASI FUNGSI UTAMA ====================
 
@@ -27,13 +32,27 @@ void initSystem() {
   circulationState = CirculationState();
   waterChangeState = WaterChangeState();
   prefillState = PrefillState();
+  sensorFaultError = ProcessError();
 
   Serial.println("System manager initialized.");
 }
 
 void tick() {
+  traceTickBegin(millis());
+
+  // Update setting dari web diterapkan utuh di batas tick
+  applyPendingSettings();
+
   // Update sensor dulu (jika perlu di setiap tick, bisa disesuaikan intervalnya)
   readSensors();
+  updateTelemetryHistory(millis());
+
+  // Cek plausibilitas sensor vs aktuator sebelum proses dijalankan,
+  // supaya proses yang terkena fault langsung berhenti di tick ini
+  applyDiagnosticFaults(runSensorDiagnostics(millis()));
+
+  // Batch produksi: lihat perintah dari luar tick sebelum proses sempat berhenti lagi
+  updateEnergyAccounting(millis());
 
   // Jalankan proses aktif satu per satu, hanya jika tidak dalam error state (untuk sekarang)
   // Kita prioritaskan filling, draining, cooling manual terlebih dahulu
@@ -59,9 +78,19 @@ void tick() {
     // TODO: runCirculationSafety(); // Akan diimplementasikan nanti
     lastSafetyCheck = millis();
   }
+
+  // ...dan perubahan proses yang terjadi di dalam tick ini
+  updateEnergyAccounting(millis());
+
+  // Terbitkan snapshot status untuk web (seq naik hanya jika ada perubahan)
+  publishStatusSnapshot(millis());
+
+  traceTickEnd();
 }
 
 void requestProcess(PROCESS_TYPE type, bool start) {
+  traceCommand((uint8_t)type, start); // Hanya tercatat jika dipanggil dari luar tick
+
   if (start) {
     if (canStartProcess(type)) {
       switch(type) {
@@ -204,12 +233,12 @@ void runFillingProcess() {
             setValveDrain(true); // Buka valve drain
             fillingState.drainStartTime = now;
             fillingState.stage = 1;
-            Serial.println("Filling: Stage 1 - Draining first 5s.");
+            Serial.println("Filling: Stage 1 - Draining first " + String((unsigned long)settings.preDrainMs) + "ms.");
         }
         break;
 
-    case 1: // Draining awal 5 detik
-        if (now - fillingState.drainStartTime >= 5000) {
+    case 1: // Draining awal (default 5 detik)
+        if (now - fillingState.drainStartTime >= settings.preDrainMs) {
             setValveDrain(false); // Tutup valve drain
             delay(500); // Tunggu sebentar agar stabil
 
@@ -238,7 +267,7 @@ void runFillingProcess() {
                 // Gunakan debounce untuk mencegah false trigger
                 if (fillingState.fullDetectedTime == 0) {
                     fillingState.fullDetectedTime = now; // Catat waktu pertama kali penuh
-                } else if (now - fillingState.fullDetectedTime >= FILLING_FLOAT_DEBOUNCE_MS) {
+                } else if (now - fillingState.fullDetectedTime >= settings.fillingFloatDebounceMs) {
                     setValveInlet(false); // Matikan valve inlet
                     fillingState.active = false; // Hentikan proses
                     fillingState.stage = 0; // Reset stage
@@ -271,7 +300,7 @@ void runDrainingProcess() {
   float currentFlowRate = getCurrentFlowRate();
 
   // Jika laju aliran di bawah ambang batas, hentikan draining
-  if (currentFlowRate < FLOW_RATE_THRESHOLD) {
+  if (currentFlowRate < settings.flowRateThreshold) {
       setValveDrain(false);
       setPumpUV(false);
       drainingState.active = false;
@@ -306,12 +335,13 @@ void runCoolingProcess() {
     return;
   }
 
+  // Tunggu konversi suhu pertama selesai sebelum mengontrol kompresor
+  if (!hasTemperatureSample()) return;
+
   // Baca suhu dari sensor_reader
   float currentTemp = getCurrentTemperature();
-  // Baca target suhu dari variabel global (misalnya dari setting manual atau auto)
-  // int targetTemp = suhuTarget; // Ambil dari variabel global atau getter
-  // Untuk sekarang, gunakan contoh target
-  int targetTemp = 15; // Ganti dengan getter nanti
+  // Target suhu dari setting runtime (bisa diubah lewat web tanpa reflash)
+  float targetTemp = settings.targetTemp;
 
   // Jika suhu gagal dibaca, hentikan proses
   if (currentTemp == -99.0) { // Kode error dari sensor_reader
@@ -333,18 +363,20 @@ void runCoolingProcess() {
           setCompressor(false);
           coolingState.initialCoolingMode = false; // Pindah ke mode histeresis
           coolingState.targetReached = true;
+          markBatchTargetReached();
           Serial.println("Cooling: Target reached, switching to hysteresis mode.");
       } else {
           setCompressor(true); // Nyalakan kompresor jika belum sampai target
       }
   } else {
       // Mode histeresis: nyalakan jika suhu naik melebihi target + histeresis
-      if (currentTemp > (targetTemp + TEMP_HYSTERESIS)) {
+      // Log hanya saat state kompresor berubah (tick berjalan jauh lebih sering dari sampel suhu)
+      if (currentTemp > (targetTemp + settings.tempHysteresis)) {
+          if (!isCompressorOn()) Serial.println("Cooling: Temp too high, compressor ON (hysteresis).");
           setCompressor(true);
-          Serial.println("Cooling: Temp too high, compressor ON (hysteresis).");
       } else if (currentTemp <= targetTemp) {
+          if (isCompressorOn()) Serial.println("Cooling: Temp OK, compressor OFF (hysteresis).");
           setCompressor(false);
-          Serial.println("Cooling: Temp OK, compressor OFF (hysteresis).");
       }
       // Jika suhu di antara target dan target+histeresis, biarkan kompresor sesuai state sebelumnya
   }
@@ -367,6 +399,58 @@ void clearError(ProcessError& errorRef) {
   Serial.println("Error cleared.");
 }
 
+// Fault diagnostik tanpa proses pemilik, urut prioritas: yang paling atas dan
+// masih aktif menjadi error sistem (risiko meluap/bocor di atas sensor mati)
+struct SystemFault {
+  uint8_t mask;
+  int code;
+  const char* message;
+};
+
+const SystemFault SYSTEM_FAULTS[] = {
+  { DIAG_FLOAT_STUCK, FLOAT_SENSOR_STUCK, "Float sensor unchanged with inlet open" },
+  { DIAG_FLOW_WITHOUT_VALVE, FLOW_SENSOR_IMPLAUSIBLE, "Flow detected with all valves closed" },
+  { DIAG_TEMP_NOT_RESPONDING, TEMP_NOT_RESPONDING, "Temperature not dropping with compressor on" },
+  { DIAG_TDS_READ_FAILED, SENSOR_READ_FAILED, "TDS sensor read failed" },
+};
+
+void applyDiagnosticFaults(uint8_t faults) {
+  uint8_t unowned = faults;
+
+  // Fault yang dimiliki proses: proses berhenti lewat jalur error biasa
+  if ((faults & DIAG_FLOAT_STUCK) && fillingState.active) {
+    if (!fillingState.error.active) {
+      setError(fillingState.error, FLOAT_SENSOR_STUCK, "Float sensor unchanged during filling");
+    }
+    unowned &= ~DIAG_FLOAT_STUCK;
+  }
+  if ((faults & DIAG_TEMP_NOT_RESPONDING) && coolingState.active) {
+    if (!coolingState.error.active) {
+      setError(coolingState.error, TEMP_NOT_RESPONDING, "Temperature not dropping with compressor on");
+    }
+    unowned &= ~DIAG_TEMP_NOT_RESPONDING;
+  }
+
+  // Sisanya jadi error sistem (hanya informasi, tidak menghentikan proses) dan
+  // hilang sendiri jika kondisinya hilang. setError() hanya saat fault
+  // prioritas tertinggi yang aktif berganti.
+  const SystemFault* top = NULL;
+  for (size_t i = 0; i < sizeof(SYSTEM_FAULTS) / sizeof(SYSTEM_FAULTS[0]); i++) {
+    if (unowned & SYSTEM_FAULTS[i].mask) {
+      top = &SYSTEM_FAULTS[i];
+      break;
+    }
+  }
+
+  if (top) {
+    if (!sensorFaultError.active || sensorFaultError.code != top->code) {
+      setError(sensorFaultError, top->code, top->message);
+    }
+  } else if (sensorFaultError.active) {
+    clearError(sensorFaultError);
+  }
+}
+
 bool canRecoverError(int errorCode) {
   // Untuk sekarang, kita tidak recovery otomatis
   // Fungsi ini bisa digunakan di Fase 2
@@ -380,4 +464,37 @@ bool isDrainingActive() { return drainingState.active; }
 bool isCoolingActive() { return coolingState.active; }
 bool isCirculationActive() { return circulationState.active; }
 bool isWaterChangeActive() { return waterChangeState.active; }
-bool isPrefillActive() { return prefillState.active; }
\ No newline at end of file
+bool isPrefillActive() { return prefillState.active; }
+
+uint8_t getActiveProcessMask() {
+  uint8_t mask = 0;
+  if (fillingState.active) mask |= 1 << PROCESS_FILLING;
+  if (drainingState.active) mask |= 1 << PROCESS_DRAINING;
+  if (coolingState.active) mask |= 1 << PROCESS_COOLING;
+  if (circulationState.active) mask |= 1 << PROCESS_CIRCULATION;
+  if (waterChangeState.active) mask |= 1 << PROCESS_WATER_CHANGE;
+  if (prefillState.active) mask |= 1 << PROCESS_PREFILL;
+  return mask;
+}
+
+int getActiveStage() {
+  if (fillingState.active) return fillingState.stage;
+  if (circulationState.active) return circulationState.stage;
+  if (waterChangeState.active) return waterChangeState.stage;
+  if (prefillState.active) return prefillState.stage;
+  return 0;
+}
+
+const ProcessError* getLatestError() {
+  // Error tetap aktif setelah proses berhenti, sampai proses dimulai ulang
+  const ProcessError* errors[] = {
+    &fillingState.error, &drainingState.error, &coolingState.error,
+    &circulationState.error, &waterChangeState.error, &prefillState.error,
+    &sensorFaultError
+  };
+  const ProcessError* latest = NULL;
+  for (const ProcessError* e : errors) {
+    if (e->active && (latest == NULL || (long)(e->startTime - latest->startTime) > 0)) latest = e;
+  }
+  return latest;
+}
\ No newline at end of file
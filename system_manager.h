@@ -12,6 +12,8 @@ enum ErrorCodes {
   SENSOR_READ_FAILED = 3,     // Sensor gagal dibaca
   TIMEOUT_ERROR = 4,          // Proses melebihi batas waktu
   LOW_FLOW_ERROR = 5,         // Flow rate terlalu rendah
+  FLOW_SENSOR_IMPLAUSIBLE = 6, // Flow sensor membaca aliran saat semua valve tertutup
+  TEMP_NOT_RESPONDING = 7,    // Suhu tidak turun walaupun kompresor menyala
   // Tambahkan kode error lain sesuai kebutuhan
 };
 
@@ -119,6 +121,11 @@ bool isCirculationActive();
 bool isWaterChangeActive();
 bool isPrefillActive();
 
+// Ringkasan status untuk web
+uint8_t getActiveProcessMask();           // Bit (1 << PROCESS_TYPE) untuk setiap proses aktif
+int getActiveStage();                     // Stage proses bertahap yang sedang aktif, 0 jika tidak ada
+const ProcessError* getLatestError();     // Error aktif paling baru, NULL jika tidak ada
+
 // ==================== DEKLARASI FUNGSI PROSES (Internal) ====================
 
 // Filling
@@ -154,4 +161,7 @@ void setError(ProcessError& errorRef, int code, String message);
 void clearError(ProcessError& errorRef);
 bool canRecoverError(int errorCode);
 
+// Teruskan fault dari sensor_diagnostics (bitmask DIAG_*) ke error proses
+void applyDiagnosticFaults(uint8_t faults);
+
 #endif // SYSTEM_MANAGER_H
\ No newline at end of file
@@ -0,0 +1,149 @@
+#include "telemetry.h"
+#include "sensor_reader.h"
+#include <Arduino.h>
+
+// Ring buffer riwayat sampel
+TelemetrySample telemetryHistory[TELEMETRY_HISTORY_SIZE];
+int telemetryHead = 0;   // Slot berikutnya yang akan ditulis
+int telemetryCount = 0;
+unsigned long lastTelemetrySampleTime = 0;
+
+// ==================== ENCODER ====================
+
+struct TelemetryWriter {
+  uint8_t* out;
+  size_t capacity;
+  size_t length;
+  bool overflow;
+
+  void putU8(uint8_t v) {
+    if (length >= capacity) { overflow = true; return; }
+    out[length++] = v;
+  }
+  void putU16(uint16_t v) { putU8(v & 0xFF); putU8(v >> 8); }
+  void putU32(uint32_t v) { putU16(v & 0xFFFF); putU16(v >> 16); }
+  void putVarint(uint32_t v) {
+    while (v >= 0x80) {
+      putU8((uint8_t)(v | 0x80));
+      v >>= 7;
+    }
+    putU8((uint8_t)v);
+  }
+  void putZigzag(int32_t v) { putVarint(((uint32_t)v << 1) ^ (uint32_t)(v >> 31)); }
+};
+
+void writeTelemetryHeader(TelemetryWriter& w, TelemetryMode mode, uint16_t count,
+                          uint32_t epoch, uint32_t frameMillis) {
+  w.putU8(TELEMETRY_MAGIC);
+  w.putU8(TELEMETRY_SCHEMA_VERSION);
+  w.putU8(mode);
+  w.putU8(0);
+  w.putU16(count);
+  // Tanggal/waktu cukup sekali per frame, bukan per sampel
+  w.putU32(epoch);
+  w.putU32(frameMillis);
+}
+
+void writeTelemetrySample(TelemetryWriter& w, const TelemetrySample& s) {
+  w.putU32(s.timeMs);
+  w.putU16((uint16_t)s.tempCenti);
+  w.putU16(s.flowCenti);
+  w.putU16((uint16_t)s.tds);
+  w.putU8(s.flags);
+}
+
+void writeTelemetryDelta(TelemetryWriter& w, const TelemetrySample& prev, const TelemetrySample& s) {
+  w.putVarint(s.timeMs - prev.timeMs);
+  w.putZigzag((int32_t)s.tempCenti - prev.tempCenti);
+  w.putZigzag((int32_t)s.flowCenti - prev.flowCenti);
+  w.putZigzag((int32_t)s.tds - prev.tds);
+  w.putU8(s.flags);
+}
+
+// ==================== SAMPEL ====================
+
+void captureTelemetrySample(TelemetrySample& out, unsigned long now) {
+  out.timeMs = now;
+  out.tempCenti = (int16_t)lround(getCurrentTemperature() * 100.0);
+  out.flowCenti = (uint16_t)lround(getCurrentFlowRate() * 100.0);
+  out.tds = (int16_t)lround(getCurrentTDS());
+  out.flags = 0;
+  const SensorSnapshot& snapshot = getSensorSnapshot();
+  if (snapshot.floatLow) out.flags |= TELEMETRY_FLAG_FLOAT_LOW;
+  if (snapshot.flowSwitchOn) out.flags |= TELEMETRY_FLAG_FLOW_SWITCH;
+  if (isRTCValid()) out.flags |= TELEMETRY_FLAG_RTC_VALID;
+}
+
+void updateTelemetryHistory(unsigned long now) {
+  if (telemetryCount > 0 && now - lastTelemetrySampleTime < TELEMETRY_HISTORY_INTERVAL_MS) return;
+  lastTelemetrySampleTime = now;
+
+  captureTelemetrySample(telemetryHistory[telemetryHead], now);
+  telemetryHead = (telemetryHead + 1) % TELEMETRY_HISTORY_SIZE;
+  if (telemetryCount < TELEMETRY_HISTORY_SIZE) telemetryCount++;
+}
+
+// Indeks sampel riwayat ke-i (0 = paling lama)
+const TelemetrySample& telemetryAt(int i) {
+  int oldest = (telemetryHead - telemetryCount + TELEMETRY_HISTORY_SIZE) % TELEMETRY_HISTORY_SIZE;
+  return telemetryHistory[(oldest + i) % TELEMETRY_HISTORY_SIZE];
+}
+
+// Sampel pertama dengan timeMs > sinceMs (riwayat urut waktu)
+int telemetryFirstAfter(uint32_t sinceMs) {
+  int first = 0;
+  while (first < telemetryCount && (int32_t)(telemetryAt(first).timeMs - sinceMs) <= 0) first++;
+  return first;
+}
+
+// ==================== ENCODE FRAME ====================
+
+size_t encodeTelemetryStatus(const TelemetrySample& sample, const TelemetryStatus& status,
+                             uint32_t epoch, uint8_t* out, size_t capacity) {
+  TelemetryWriter w = { out, capacity, 0, false };
+  writeTelemetryHeader(w, TELEMETRY_STATUS, 1, epoch, sample.timeMs);
+  writeTelemetrySample(w, sample);
+  w.putU8(status.processMask);
+  w.putU8(status.stage);
+  w.putU8(status.errorCode);
+  return w.overflow ? 0 : w.length;
+}
+
+size_t encodeTelemetryHistory(uint32_t sinceMs, TelemetryMode mode, uint8_t* out, size_t capacity) {
+  int first = sinceMs ? telemetryFirstAfter(sinceMs) : 0;
+  uint16_t count = telemetryCount - first;
+
+  TelemetryWriter w = { out, capacity, 0, false };
+  writeTelemetryHeader(w, mode, count, getRTCEpoch(), millis());
+  for (int i = first; i < telemetryCount; i++) {
+    if (mode == TELEMETRY_DELTA && i > first) {
+      writeTelemetryDelta(w, telemetryAt(i - 1), telemetryAt(i));
+    } else {
+      writeTelemetrySample(w, telemetryAt(i));
+    }
+  }
+  return w.overflow ? 0 : w.length;
+}
+
+String getTelemetryHistoryJSON(uint32_t sinceMs) {
+  int first = sinceMs ? telemetryFirstAfter(sinceMs) : 0;
+  String json = "{\"epoch\":" + String((unsigned long)getRTCEpoch());
+  json += ",\"millis\":" + String(millis());
+  json += ",\"samples\":[";
+  for (int i = first; i < telemetryCount; i++) {
+    const TelemetrySample& s = telemetryAt(i);
+    if (i > first) json += ",";
+    json += "[" + String((unsigned long)s.timeMs);
+    json += "," + String(s.tempCenti / 100.0, 2);
+    json += "," + String(s.flowCenti / 100.0, 2);
+    json += "," + String((int)s.tds);
+    json += "," + String((int)s.flags) + "]";
+  }
+  json += "]}";
+  return json;
+}
+
+bool acceptsBinaryTelemetry(const String& acceptHeader) {
+  return acceptHeader.indexOf(TELEMETRY_CONTENT_TYPE) >= 0 ||
+         acceptHeader.indexOf("application/octet-stream") >= 0;
+}
@@ -0,0 +1,74 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <Arduino.h>
+
+// ==================== FORMAT TELEMETRI BINER (little-endian) ====================
+// Frame = header 14 byte + sampel.
+//   0     : magic 'T'
+//   1     : versi skema
+//   2     : mode (TELEMETRY_FIXED / TELEMETRY_DELTA / TELEMETRY_STATUS)
+//   3     : reserved (0)
+//   4..5  : jumlah sampel (u16)
+//   6..9  : epoch RTC saat frame dibuat (u32, 0 = RTC tidak valid)
+//   10..13: millis() saat frame dibuat (u32) -> waktu sampel = epoch + (timeMs - nilai ini) / 1000
+// Sampel fixed (11 byte): timeMs u32, suhu x100 i16, flow x100 u16, tds i16, flags u8
+// Mode delta: sampel pertama fixed, berikutnya varint(selisih timeMs),
+// zigzag varint(selisih suhu, flow, tds), flags u8.
+// Mode status (skema 2, /api/status): satu sampel fixed lalu status proses
+// 3 byte: mask proses u8, stage u8, kode error u8.
+// Decoder untuk dashboard ada di script.js (decodeTelemetry).
+#define TELEMETRY_MAGIC               'T'
+#define TELEMETRY_SCHEMA_VERSION      2
+#define TELEMETRY_CONTENT_TYPE        "application/vnd.icebatch.telemetry"
+#define TELEMETRY_HEADER_SIZE         14
+#define TELEMETRY_SAMPLE_SIZE         11
+#define TELEMETRY_STATUS_SIZE         3
+#define TELEMETRY_HISTORY_SIZE        300  // Sampel riwayat (5 menit @ 1 detik)
+#define TELEMETRY_HISTORY_INTERVAL_MS 1000
+#define TELEMETRY_BUFFER_SIZE         (TELEMETRY_HEADER_SIZE + TELEMETRY_HISTORY_SIZE * TELEMETRY_SAMPLE_SIZE)
+
+// Bit flags sampel
+#define TELEMETRY_FLAG_FLOAT_LOW      0x01
+#define TELEMETRY_FLAG_FLOW_SWITCH    0x02
+#define TELEMETRY_FLAG_RTC_VALID      0x04
+
+enum TelemetryMode {
+  TELEMETRY_FIXED = 0,
+  TELEMETRY_DELTA = 1,
+  TELEMETRY_STATUS = 2
+};
+
+struct TelemetrySample {
+  uint32_t timeMs = 0;
+  int16_t tempCenti = 0;   // -9900 = sensor suhu error
+  uint16_t flowCenti = 0;
+  int16_t tds = 0;         // -1 = sensor TDS error
+  uint8_t flags = 0;
+};
+
+struct TelemetryStatus {
+  uint8_t processMask = 0;
+  uint8_t stage = 0;
+  uint8_t errorCode = 0;
+};
+
+// Ambil sampel dari nilai sensor saat ini
+void captureTelemetrySample(TelemetrySample& out, unsigned long now);
+
+// Simpan sampel riwayat setiap TELEMETRY_HISTORY_INTERVAL_MS. Dipanggil dari tick().
+void updateTelemetryHistory(unsigned long now);
+
+// Encode ke buffer; mengembalikan jumlah byte (0 jika buffer kurang).
+// Frame status memakai epoch dari snapshot dan timeMs sampel sebagai millis header.
+size_t encodeTelemetryStatus(const TelemetrySample& sample, const TelemetryStatus& status,
+                             uint32_t epoch, uint8_t* out, size_t capacity);
+size_t encodeTelemetryHistory(uint32_t sinceMs, TelemetryMode mode, uint8_t* out, size_t capacity);
+
+// Riwayat dalam format JSON (untuk klien tanpa decoder biner)
+String getTelemetryHistoryJSON(uint32_t sinceMs);
+
+// Content negotiation: true jika header Accept meminta format biner
+bool acceptsBinaryTelemetry(const String& acceptHeader);
+
+#endif
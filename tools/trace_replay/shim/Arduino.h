@@ -0,0 +1,111 @@
+#ifndef ARDUINO_SHIM_H
+#define ARDUINO_SHIM_H
+
+// Pengganti minimal Arduino core untuk build host (trace replay).
+// Hanya API yang dipakai oleh modul kontrol yang disediakan di sini.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define RISING 0x01
+#define FALLING 0x02
+#define IRAM_ATTR
+
+// ==================== WAKTU (virtual, dikendalikan replay) ====================
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void shimSetMillis(unsigned long ms);
+
+// ==================== GPIO ====================
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+int digitalPinToInterrupt(uint8_t pin);
+void attachInterrupt(int irq, void (*isr)(), int mode);
+void noInterrupts();
+void interrupts();
+
+// ==================== STRING ====================
+class String {
+public:
+  String() {}
+  String(const char* s) : s_(s ? s : "") {}
+  String(const std::string& s) : s_(s) {}
+  String(char c) : s_(1, c) {}
+  String(int v) : s_(std::to_string(v)) {}
+  String(unsigned int v) : s_(std::to_string(v)) {}
+  String(long v) : s_(std::to_string(v)) {}
+  String(unsigned long v) : s_(std::to_string(v)) {}
+  String(float v, unsigned int decimals = 2) { format(v, decimals); }
+  String(double v, unsigned int decimals = 2) { format(v, decimals); }
+
+  const char* c_str() const { return s_.c_str(); }
+  unsigned int length() const { return (unsigned int)s_.size(); }
+  bool equals(const String& o) const { return s_ == o.s_; }
+  bool operator==(const String& o) const { return s_ == o.s_; }
+  bool operator!=(const String& o) const { return s_ != o.s_; }
+  String& operator+=(const String& o) { s_ += o.s_; return *this; }
+  String& operator+=(const char* o) { s_ += o; return *this; }
+  String& operator+=(char c) { s_ += c; return *this; }
+  void reserve(unsigned int n) { s_.reserve(n); }
+  int indexOf(const char* needle) const {
+    size_t pos = s_.find(needle);
+    return pos == std::string::npos ? -1 : (int)pos;
+  }
+  int indexOf(const String& needle) const { return indexOf(needle.c_str()); }
+  int toInt() const { return atoi(s_.c_str()); }
+  float toFloat() const { return (float)atof(s_.c_str()); }
+
+  friend String operator+(const String& a, const String& b) { return String(a.s_ + b.s_); }
+  friend String operator+(const String& a, const char* b) { return String(a.s_ + b); }
+  friend String operator+(const char* a, const String& b) { return String(a + b.s_); }
+
+private:
+  void format(double v, unsigned int decimals) {
+    char buf[48];
+    snprintf(buf, sizeof(buf), "%.*f", (int)decimals, v);
+    s_ = buf;
+  }
+  std::string s_;
+};
+
+// ==================== PRINT / SERIAL ====================
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t b) = 0;
+  virtual size_t write(const uint8_t* buf, size_t len) {
+    size_t n = 0;
+    while (len--) n += write(*buf++);
+    return n;
+  }
+};
+
+class HardwareSerial : public Print {
+public:
+  bool echo = false;
+  void begin(unsigned long) {}
+  size_t write(uint8_t b) override { if (echo) fputc(b, stdout); return 1; }
+  void print(const String& s) { if (echo) fputs(s.c_str(), stdout); }
+  void print(const char* s) { print(String(s)); }
+  void print(int v) { print(String(v)); }
+  void print(unsigned long v) { print(String(v)); }
+  void print(float v, int d = 2) { print(String(v, d)); }
+  void println() { print("\n"); }
+  template <typename T> void println(const T& v) { print(v); println(); }
+};
+
+extern HardwareSerial Serial;
+
+#endif
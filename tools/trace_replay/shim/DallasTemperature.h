@@ -0,0 +1,19 @@
+#ifndef DALLAS_TEMPERATURE_SHIM_H
+#define DALLAS_TEMPERATURE_SHIM_H
+
+#include <Arduino.h>
+#include <OneWire.h>
+
+// Suhu sebenarnya disuplai oleh traceTemperature() saat replay
+class DallasTemperature {
+public:
+  explicit DallasTemperature(OneWire*) {}
+  void begin() {}
+  void setWaitForConversion(bool) {}
+  uint8_t getResolution() { return 12; }
+  int16_t millisToWaitForConversion(uint8_t bitResolution) { return 750 / (1 << (12 - bitResolution)); }
+  void requestTemperatures() {}
+  float getTempCByIndex(uint8_t) { return 0.0f; }
+};
+
+#endif
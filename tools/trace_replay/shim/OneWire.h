@@ -0,0 +1,11 @@
+#ifndef ONEWIRE_SHIM_H
+#define ONEWIRE_SHIM_H
+
+#include <Arduino.h>
+
+class OneWire {
+public:
+  explicit OneWire(uint8_t) {}
+};
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef PREFERENCES_SHIM_H
+#define PREFERENCES_SHIM_H
+
+#include <Arduino.h>
+#include <map>
+#include <vector>
+
+// NVS di memori: isi hilang saat program selesai
+class Preferences {
+public:
+  bool begin(const char* name, bool readOnly = false);
+  void end() {}
+  size_t getBytesLength(const char* key);
+  size_t getBytes(const char* key, void* buf, size_t maxLen);
+  size_t putBytes(const char* key, const void* value, size_t len);
+  bool remove(const char* key);
+
+private:
+  std::string ns_;
+};
+
+#endif
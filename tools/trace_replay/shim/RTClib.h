@@ -0,0 +1,30 @@
+#ifndef RTCLIB_SHIM_H
+#define RTCLIB_SHIM_H
+
+#include <Arduino.h>
+
+class DateTime {
+public:
+  DateTime(uint32_t t = 0) : t_(t) {}
+  uint8_t hour() const { return (t_ / 3600) % 24; }
+  uint8_t minute() const { return (t_ / 60) % 60; }
+  uint8_t second() const { return t_ % 60; }
+  uint8_t day() const { return 1; }
+  uint8_t month() const { return 1; }
+  uint16_t year() const { return 2000; }
+  uint32_t unixtime() const { return t_; }
+
+private:
+  uint32_t t_;
+};
+
+// RTC tidak terpasang di host: begin() gagal sehingga rtcValid = false
+class RTC_DS3231 {
+public:
+  bool begin() { return false; }
+  bool lostPower() { return true; }
+  void adjust(const DateTime&) {}
+  DateTime now() { return DateTime(millis() / 1000); }
+};
+
+#endif
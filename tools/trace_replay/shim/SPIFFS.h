@@ -0,0 +1,39 @@
+#ifndef SPIFFS_SHIM_H
+#define SPIFFS_SHIM_H
+
+#include <Arduino.h>
+#include <map>
+#include <vector>
+
+// SPIFFS di memori: isi hilang saat program selesai
+class File {
+public:
+  File() {}
+  File(std::vector<uint8_t>* data, bool write) : data_(data), write_(write) {}
+  explicit operator bool() const { return data_ != nullptr; }
+  size_t read(uint8_t* buf, size_t len);
+  size_t write(const uint8_t* buf, size_t len);
+  size_t size() const { return data_ ? data_->size() : 0; }
+  void close() { data_ = nullptr; }
+
+private:
+  std::vector<uint8_t>* data_ = nullptr;
+  bool write_ = false;
+  size_t pos_ = 0;
+};
+
+class SPIFFSFS {
+public:
+  bool begin(bool formatOnFail = false) { return true; }
+  File open(const String& path, const char* mode = "r");
+  bool exists(const String& path) { return files_.count(path.c_str()) > 0; }
+  bool remove(const String& path) { return files_.erase(path.c_str()) > 0; }
+  bool rename(const String& from, const String& to);
+
+private:
+  std::map<std::string, std::vector<uint8_t>> files_;
+};
+
+extern SPIFFSFS SPIFFS;
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef WIRE_SHIM_H
+#define WIRE_SHIM_H
+
+#include <Arduino.h>
+
+class TwoWire {
+public:
+  bool begin(int, int) { return true; }
+};
+
+extern TwoWire Wire;
+
+#endif
@@ -0,0 +1,23 @@
+#include "Arduino.h"
+#include "Wire.h"
+
+// Jam virtual: tetap selama satu tick, diatur oleh replay dari record TRACE_TICK
+static unsigned long virtualMillis = 0;
+
+HardwareSerial Serial;
+TwoWire Wire;
+
+unsigned long millis() { return virtualMillis; }
+unsigned long micros() { return virtualMillis * 1000UL; }
+void delay(unsigned long) {}
+void shimSetMillis(unsigned long ms) { virtualMillis = ms; }
+
+// Input fisik tidak dipakai: nilai sebenarnya disuplai oleh tap trace
+void pinMode(uint8_t, uint8_t) {}
+void digitalWrite(uint8_t, uint8_t) {}
+int digitalRead(uint8_t) { return LOW; }
+int analogRead(uint8_t) { return 0; }
+int digitalPinToInterrupt(uint8_t pin) { return pin; }
+void attachInterrupt(int, void (*)(), int) {}
+void noInterrupts() {}
+void interrupts() {}
@@ -0,0 +1,35 @@
+#include "Preferences.h"
+
+static std::map<std::string, std::vector<uint8_t>> nvsStore;
+
+bool Preferences::begin(const char* name, bool readOnly) {
+  ns_ = name;
+  if (!readOnly) return true;
+  // Seperti NVS: namespace read-only gagal dibuka jika belum pernah ditulis
+  for (auto& entry : nvsStore) {
+    if (entry.first.compare(0, ns_.size() + 1, ns_ + "/") == 0) return true;
+  }
+  return false;
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+  auto it = nvsStore.find(ns_ + "/" + key);
+  return it == nvsStore.end() ? 0 : it->second.size();
+}
+
+size_t Preferences::getBytes(const char* key, void* buf, size_t maxLen) {
+  auto it = nvsStore.find(ns_ + "/" + key);
+  if (it == nvsStore.end() || it->second.size() > maxLen) return 0;
+  memcpy(buf, it->second.data(), it->second.size());
+  return it->second.size();
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t len) {
+  const uint8_t* p = (const uint8_t*)value;
+  nvsStore[ns_ + "/" + key] = std::vector<uint8_t>(p, p + len);
+  return len;
+}
+
+bool Preferences::remove(const char* key) {
+  return nvsStore.erase(ns_ + "/" + key) > 0;
+}
@@ -0,0 +1,36 @@
+#include "SPIFFS.h"
+#include <algorithm>
+
+SPIFFSFS SPIFFS;
+
+size_t File::read(uint8_t* buf, size_t len) {
+  if (!data_ || write_) return 0;
+  size_t n = std::min(len, data_->size() - pos_);
+  memcpy(buf, data_->data() + pos_, n);
+  pos_ += n;
+  return n;
+}
+
+size_t File::write(const uint8_t* buf, size_t len) {
+  if (!data_ || !write_) return 0;
+  data_->insert(data_->end(), buf, buf + len);
+  return len;
+}
+
+File SPIFFSFS::open(const String& path, const char* mode) {
+  if (mode[0] == 'w') {
+    std::vector<uint8_t>& data = files_[path.c_str()];
+    data.clear();
+    return File(&data, true);
+  }
+  auto it = files_.find(path.c_str());
+  return it == files_.end() ? File() : File(&it->second, false);
+}
+
+bool SPIFFSFS::rename(const String& from, const String& to) {
+  auto it = files_.find(from.c_str());
+  if (it == files_.end()) return false;
+  files_[to.c_str()] = it->second;
+  files_.erase(from.c_str());
+  return true;
+}
@@ -0,0 +1,321 @@
+// ==================== TRACE REPLAY (host) ====================
+// Memutar ulang trace dari device (GET /api/trace) ke system_manager.cpp asli
+// secepat mungkin, membandingkan keputusan aktuator dengan rekaman, dan
+// melaporkan biaya CPU per tick.
+//
+// Build (dari root repo):
+//   g++ -std=c++17 -O2 -Itools/trace_replay/shim -I. -o trace_replay
+//       tools/trace_replay/trace_replay.cpp tools/trace_replay/shim/arduino_shim.cpp
+//       system_manager.cpp sensor_reader.cpp digital_control.cpp settings_store.cpp
+//       telemetry.cpp response_cache.cpp sensor_diagnostics.cpp energy_accounting.cpp
+//       sensor_rollup.cpp tools/trace_replay/shim/preferences_shim.cpp
+//       tools/trace_replay/shim/spiffs_shim.cpp
+//
+// Pemakaian:
+//   ./trace_replay trace.bin [-v]
+//   -v : tampilkan output Serial dari firmware selama replay
+//
+// Catatan:
+// - Replay dimulai dari initSystem() (semua proses idle), jadi mulai rekaman
+//   saat sistem idle agar hasilnya bisa dibandingkan.
+// - Edge input digital diterapkan di awal tick tempat edge itu tercatat.
+// - Exit code 0 jika semua keputusan aktuator sama, 1 jika ada perbedaan.
+
+#include <Arduino.h>
+#include "../../trace_recorder.h"
+#include "../../system_manager.h"
+#include "../../sensor_reader.h"
+#include "../../settings_store.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+// ==================== STATE TAP (sisi host) ====================
+const int REPLAY_PIN_COUNT = 40;
+
+int replayAdc[REPLAY_PIN_COUNT];
+bool replayDigital[REPLAY_PIN_COUNT];
+float replayTemp = 0.0f;
+unsigned long replayFlowPulses = 0;
+
+int8_t producedState[REPLAY_PIN_COUNT];
+std::vector<std::pair<uint8_t, bool>> producedActuators;
+
+void traceTickBegin(unsigned long) {}
+void traceTickEnd() {}
+void traceCommand(uint8_t, bool) {}
+void traceSettings(const uint8_t*, size_t) {}
+
+int traceAnalogInput(uint8_t pin, int raw) {
+  return pin < REPLAY_PIN_COUNT ? replayAdc[pin] : raw;
+}
+
+float traceTemperature(float) {
+  return replayTemp;
+}
+
+unsigned long traceFlowPulses(unsigned long, unsigned long) {
+  return replayFlowPulses;
+}
+
+bool traceDigitalInput(uint8_t pin, bool level) {
+  return pin < REPLAY_PIN_COUNT ? replayDigital[pin] : level;
+}
+
+void traceActuator(uint8_t pin, bool state) {
+  // Aturan yang sama dengan recorder: hanya perubahan state yang dihitung
+  if (pin >= REPLAY_PIN_COUNT || producedState[pin] == (int8_t)state) return;
+  producedState[pin] = state;
+  producedActuators.push_back(std::make_pair(pin, state));
+}
+
+// Tidak dipakai di host
+void startTraceRecording() {}
+void stopTraceRecording() {}
+bool isTraceRecording() { return false; }
+size_t getTraceSize() { return 0; }
+size_t writeTrace(Print&) { return 0; }
+
+// ==================== DECODER ====================
+struct TraceEvent {
+  uint8_t type;
+  uint8_t pin;
+  bool level;
+  long value;            // Nilai absolut (waktu tick, kode ADC, suhu x128, pulsa)
+  RuntimeSettings settings; // Hanya untuk TRACE_SETTINGS
+};
+
+struct TraceReader {
+  const uint8_t* data;
+  size_t size;
+  size_t pos;
+
+  bool readByte(uint8_t& b) {
+    if (pos >= size) return false;
+    b = data[pos++];
+    return true;
+  }
+
+  bool readVarint(uint32_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+      uint8_t b;
+      if (!readByte(b)) return false;
+      v |= (uint32_t)(b & 0x7F) << shift;
+      if (!(b & 0x80)) return true;
+    }
+    return false;
+  }
+
+  bool readZigzag(int32_t& v) {
+    uint32_t u;
+    if (!readVarint(u)) return false;
+    v = (int32_t)(u >> 1) ^ -(int32_t)(u & 1);
+    return true;
+  }
+};
+
+bool decodeTrace(const std::vector<uint8_t>& file, TraceHeader& header, std::vector<TraceEvent>& events) {
+  if (file.size() < sizeof(TraceHeader)) return false;
+  memcpy(&header, file.data(), sizeof(TraceHeader));
+  if (header.magic != TRACE_MAGIC || header.version > TRACE_VERSION) return false;
+  if (header.headerSize + (size_t)header.dataSize > file.size()) return false;
+
+  TraceReader reader = { file.data() + header.headerSize, header.dataSize, 0 };
+  unsigned long tickTime = header.startMillis;
+  int adc[REPLAY_PIN_COUNT] = {0};
+  long temp = 0;
+
+  while (reader.pos < reader.size) {
+    uint8_t head;
+    reader.readByte(head);
+    TraceEvent e;
+    e.type = head & TRACE_TYPE_MASK;
+    e.level = (head & TRACE_LEVEL_BIT) != 0;
+    e.pin = 0;
+    e.value = 0;
+
+    bool ok = true;
+    uint32_t u;
+    int32_t z;
+    switch (e.type) {
+      case TRACE_TICK:
+        ok = reader.readVarint(u);
+        tickTime += u;
+        e.value = (long)tickTime;
+        break;
+      case TRACE_TICK_END:
+        break;
+      case TRACE_IDLE_TICKS: {
+        // Dibuka menjadi tick kosong biasa (tanpa input baru, tanpa aktuator),
+        // lalu TICK_END agar record berikutnya tidak masuk ke tick terakhir
+        uint32_t period;
+        ok = reader.readVarint(u) && reader.readVarint(period);
+        for (uint32_t n = 0; ok && n < u; n++) {
+          tickTime += period;
+          TraceEvent idle = e;
+          idle.type = TRACE_TICK;
+          idle.value = (long)tickTime;
+          events.push_back(idle);
+        }
+        e.type = TRACE_TICK_END;
+        break;
+      }
+      case TRACE_ADC:
+        ok = reader.readByte(e.pin) && reader.readZigzag(z) && e.pin < REPLAY_PIN_COUNT;
+        if (ok) e.value = adc[e.pin] += z;
+        break;
+      case TRACE_TEMP:
+        ok = reader.readZigzag(z);
+        e.value = temp += z;
+        break;
+      case TRACE_FLOW:
+        ok = reader.readVarint(u);
+        e.value = (long)u;
+        ok = ok && reader.readVarint(u); // Waktu pulsa terakhir: informasi saja
+        break;
+      case TRACE_DIGITAL_EDGE:
+      case TRACE_ACTUATOR:
+      case TRACE_COMMAND:
+        ok = reader.readByte(e.pin) && e.pin < REPLAY_PIN_COUNT;
+        break;
+      case TRACE_SETTINGS:
+        // Field yang tidak ada di trace lama tetap default
+        ok = reader.readVarint(u) && reader.pos + u <= reader.size;
+        if (ok) {
+          memcpy(&e.settings, reader.data + reader.pos, std::min((size_t)u, sizeof(RuntimeSettings)));
+          reader.pos += u;
+        }
+        break;
+      default:
+        ok = false;
+    }
+    if (!ok) {
+      fprintf(stderr, "Trace rusak di offset %zu\n", reader.pos);
+      return false;
+    }
+    events.push_back(e);
+  }
+  return true;
+}
+
+// ==================== REPLAY ====================
+bool isInputEvent(uint8_t type) {
+  return type == TRACE_ADC || type == TRACE_TEMP || type == TRACE_FLOW || type == TRACE_DIGITAL_EDGE ||
+         type == TRACE_SETTINGS;
+}
+
+void applyInput(const TraceEvent& e) {
+  switch (e.type) {
+    case TRACE_ADC: replayAdc[e.pin] = (int)e.value; break;
+    case TRACE_TEMP: replayTemp = e.value / 128.0f; break;
+    case TRACE_FLOW: replayFlowPulses = (unsigned long)e.value; break;
+    case TRACE_DIGITAL_EDGE: replayDigital[e.pin] = e.level; break;
+    case TRACE_SETTINGS: settings = e.settings; break;
+  }
+}
+
+String formatActuators(const std::vector<std::pair<uint8_t, bool>>& list) {
+  String s = "[";
+  for (size_t i = 0; i < list.size(); i++) {
+    if (i) s += " ";
+    s += String((int)list[i].first) + (list[i].second ? "=ON" : "=OFF");
+  }
+  s += "]";
+  return s;
+}
+
+int main(int argc, char** argv) {
+  const char* path = nullptr;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-v") == 0) Serial.echo = true;
+    else path = argv[i];
+  }
+  if (!path) {
+    fprintf(stderr, "Pemakaian: %s trace.bin [-v]\n", argv[0]);
+    return 2;
+  }
+
+  std::ifstream in(path, std::ios::binary);
+  std::vector<uint8_t> file((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  TraceHeader header;
+  std::vector<TraceEvent> events;
+  if (!decodeTrace(file, header, events)) {
+    fprintf(stderr, "Gagal membaca trace: %s\n", path);
+    return 2;
+  }
+
+  memset(producedState, -1, sizeof(producedState));
+  shimSetMillis(header.startMillis);
+  initSystem();
+  resetSamplingSchedule(header.startMillis); // Titik sinkron yang sama dengan startTraceRecording()
+
+  std::vector<long long> tickCostNs;
+  tickCostNs.reserve(header.tickCount);
+  unsigned long mismatches = 0;
+  std::vector<std::pair<uint8_t, bool>> expected;
+
+  size_t i = 0;
+  while (i < events.size()) {
+    expected.clear();
+    producedActuators.clear();
+    bool inTick = events[i].type == TRACE_TICK;
+    unsigned long segmentTime = millis();
+
+    if (inTick) {
+      segmentTime = (unsigned long)events[i].value;
+      shimSetMillis(segmentTime);
+      size_t j = i + 1;
+      for (; j < events.size() && events[j].type != TRACE_TICK && events[j].type != TRACE_TICK_END; j++) {
+        if (isInputEvent(events[j].type)) applyInput(events[j]);
+        else if (events[j].type == TRACE_ACTUATOR) expected.push_back(std::make_pair(events[j].pin, events[j].level));
+      }
+
+      auto t0 = std::chrono::steady_clock::now();
+      tick();
+      auto t1 = std::chrono::steady_clock::now();
+      tickCostNs.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+
+      i = j;
+      if (i < events.size() && events[i].type == TRACE_TICK_END) i++;
+    } else {
+      // Di luar tick: perintah dari web dan input yang dibaca di luar kontrol
+      for (; i < events.size() && events[i].type != TRACE_TICK; i++) {
+        const TraceEvent& e = events[i];
+        if (isInputEvent(e.type)) applyInput(e);
+        else if (e.type == TRACE_ACTUATOR) expected.push_back(std::make_pair(e.pin, e.level));
+        else if (e.type == TRACE_COMMAND) requestProcess((PROCESS_TYPE)e.pin, e.level);
+      }
+    }
+
+    if (expected != producedActuators) {
+      mismatches++;
+      if (mismatches <= 20) {
+        printf("MISMATCH t=%lu ms (%s, tick #%zu): rekaman %s, replay %s\n",
+               segmentTime - header.startMillis, inTick ? "tick" : "luar tick", tickCostNs.size(),
+               formatActuators(expected).c_str(), formatActuators(producedActuators).c_str());
+      }
+    }
+  }
+
+  printf("Trace   : %s, %u byte data, %zu event, %zu tick%s\n", path, header.dataSize, events.size(),
+         tickCostNs.size(), header.truncated ? " (terpotong: buffer device penuh)" : "");
+  printf("Durasi  : %lu ms waktu device\n", millis() - header.startMillis);
+  printf("Selisih : %lu segmen berbeda\n", mismatches);
+
+  if (!tickCostNs.empty()) {
+    std::vector<long long> sorted(tickCostNs);
+    std::sort(sorted.begin(), sorted.end());
+    long long total = 0;
+    for (long long c : sorted) total += c;
+    printf("CPU/tick: mean %lld ns, p50 %lld ns, p99 %lld ns, max %lld ns (total %.3f ms)\n",
+           total / (long long)sorted.size(), sorted[sorted.size() / 2],
+           sorted[(sorted.size() * 99) / 100], sorted.back(), total / 1e6);
+  }
+
+  return mismatches ? 1 : 0;
+}
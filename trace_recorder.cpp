@@ -0,0 +1,275 @@
+#include "trace_recorder.h"
+#include "sensor_reader.h" // resetSamplingSchedule()
+#include "settings_store.h"
+#include <Arduino.h>
+
+// Buffer rekaman (linear, berhenti saat penuh agar replay selalu mulai dari awal)
+uint8_t traceBuffer[TRACE_BUFFER_SIZE];
+size_t traceLength = 0;
+
+bool traceRecording = false;
+bool traceTruncated = false;
+bool traceInTick = false;
+bool tracePendingTickEnd = false;
+bool tracePendingTick = false;        // TRACE_TICK tick ini belum ditulis
+uint32_t tracePendingTickDelta = 0;
+uint32_t traceIdleCount = 0;          // Run tick kosong yang belum ditulis
+uint32_t traceIdlePeriod = 0;
+unsigned long traceStartMillis = 0;
+unsigned long traceLastTickMillis = 0;
+unsigned long traceTickCount = 0;
+
+// Nilai terakhir yang dicatat (input hanya dicatat saat berubah)
+const int TRACE_PIN_COUNT = 40;
+int8_t lastDigitalLevel[TRACE_PIN_COUNT];
+int8_t lastActuatorState[TRACE_PIN_COUNT];
+int lastAdcCode[TRACE_PIN_COUNT];
+bool adcLogged[TRACE_PIN_COUNT];
+long lastTempRaw = 0;
+bool tempLogged = false;
+unsigned long lastFlowPulses = 0;
+unsigned long lastFlowMicros = 0;
+bool flowLogged = false;
+
+// ==================== ENCODER ====================
+
+void traceWriteByte(uint8_t b) {
+  traceBuffer[traceLength++] = b;
+}
+
+void traceWriteVarint(uint32_t v) {
+  while (v >= 0x80) {
+    traceWriteByte((uint8_t)(v | 0x80));
+    v >>= 7;
+  }
+  traceWriteByte((uint8_t)v);
+}
+
+void traceWriteZigzag(int32_t v) {
+  traceWriteVarint(((uint32_t)v << 1) ^ (uint32_t)(v >> 31));
+}
+
+size_t traceEncodeVarint(uint8_t* out, uint32_t v) {
+  size_t len = 0;
+  while (v >= 0x80) {
+    out[len++] = (uint8_t)(v | 0x80);
+    v >>= 7;
+  }
+  out[len++] = (uint8_t)v;
+  return len;
+}
+
+// Record run tick kosong ke `out` (maks TRACE_MAX_RECORD byte). Terpisah dari
+// buffer agar writeTrace() bisa menambahkan run yang masih berjalan.
+size_t traceEncodeIdleRun(uint8_t* out) {
+  size_t len = 0;
+  out[len++] = TRACE_IDLE_TICKS;
+  len += traceEncodeVarint(out + len, traceIdleCount);
+  len += traceEncodeVarint(out + len, traceIdlePeriod);
+  return len;
+}
+
+// Siapkan satu record: cek ruang buffer, tulis run tick kosong dan TRACE_TICK
+// yang tertunda, dan tutup tick jika record datang dari luar tick
+bool traceBeginRecord(size_t recordSize = TRACE_MAX_RECORD) {
+  if (!traceRecording) return false;
+  // Cadangan untuk run idle + TRACE_TICK/TRACE_TICK_END yang tertunda
+  if (traceLength + recordSize + 2 * TRACE_MAX_RECORD > TRACE_BUFFER_SIZE) {
+    traceRecording = false;
+    traceTruncated = true;
+    Serial.println("Trace: Buffer penuh, rekaman dihentikan.");
+    return false;
+  }
+  if (traceIdleCount > 0) {
+    traceLength += traceEncodeIdleRun(traceBuffer + traceLength);
+    traceIdleCount = 0;
+  }
+  if (!traceInTick && tracePendingTickEnd) {
+    traceWriteByte(TRACE_TICK_END);
+    tracePendingTickEnd = false;
+  }
+  if (traceInTick && tracePendingTick) {
+    traceWriteByte(TRACE_TICK);
+    traceWriteVarint(tracePendingTickDelta);
+    traceTickCount++;
+    tracePendingTick = false;
+  }
+  return true;
+}
+
+bool tracePinValid(uint8_t pin) {
+  return pin < TRACE_PIN_COUNT;
+}
+
+// ==================== TAP INPUT/OUTPUT ====================
+
+// TRACE_TICK baru ditulis oleh record pertama di dalam tick (traceBeginRecord)
+void traceTickBegin(unsigned long now) {
+  traceInTick = true;
+  if (!traceRecording) return;
+  tracePendingTick = true;
+  tracePendingTickDelta = (uint32_t)(now - traceLastTickMillis);
+  traceLastTickMillis = now;
+  tracePendingTickEnd = false;
+}
+
+void traceTickEnd() {
+  traceInTick = false;
+  if (!traceRecording) return;
+  if (!tracePendingTick) {
+    tracePendingTickEnd = true;
+    return;
+  }
+  // Tick tanpa record: perpanjang run idle jika jaraknya sama, jika tidak mulai run baru
+  tracePendingTick = false;
+  if (traceIdleCount > 0 && tracePendingTickDelta != traceIdlePeriod) {
+    if (traceLength + 2 * TRACE_MAX_RECORD > TRACE_BUFFER_SIZE) {
+      traceRecording = false;
+      traceTruncated = true;
+      Serial.println("Trace: Buffer penuh, rekaman dihentikan.");
+      return;
+    }
+    traceLength += traceEncodeIdleRun(traceBuffer + traceLength);
+    traceIdleCount = 0;
+  }
+  traceIdlePeriod = tracePendingTickDelta;
+  traceIdleCount++;
+  traceTickCount++;
+}
+
+int traceAnalogInput(uint8_t pin, int raw) {
+  if (!tracePinValid(pin)) return raw;
+  if (adcLogged[pin] && lastAdcCode[pin] == raw) return raw;
+  if (!traceBeginRecord()) return raw;
+  traceWriteByte(TRACE_ADC);
+  traceWriteByte(pin);
+  traceWriteZigzag(raw - (adcLogged[pin] ? lastAdcCode[pin] : 0));
+  lastAdcCode[pin] = raw;
+  adcLogged[pin] = true;
+  return raw;
+}
+
+float traceTemperature(float tempC) {
+  // Resolusi DallasTemperature 1/128 C, jadi nilai x128 disimpan tanpa kehilangan presisi
+  long rawTemp = lround(tempC * 128.0);
+  if (tempLogged && lastTempRaw == rawTemp) return tempC;
+  if (!traceBeginRecord()) return tempC;
+  traceWriteByte(TRACE_TEMP);
+  traceWriteZigzag((int32_t)(rawTemp - (tempLogged ? lastTempRaw : 0)));
+  lastTempRaw = rawTemp;
+  tempLogged = true;
+  return tempC;
+}
+
+unsigned long traceFlowPulses(unsigned long pulses, unsigned long lastPulseMicros) {
+  // Catat setiap jendela yang berisi pulsa (beserta waktu pulsa terakhir),
+  // dan jendela kosong hanya saat transisi ke nol
+  if (flowLogged && pulses == 0 && lastFlowPulses == 0) return pulses;
+  if (!traceBeginRecord()) return pulses;
+  traceWriteByte(TRACE_FLOW);
+  traceWriteVarint((uint32_t)pulses);
+  traceWriteVarint((uint32_t)(lastPulseMicros - lastFlowMicros));
+  lastFlowPulses = pulses;
+  lastFlowMicros = lastPulseMicros;
+  flowLogged = true;
+  return pulses;
+}
+
+bool traceDigitalInput(uint8_t pin, bool level) {
+  if (!tracePinValid(pin)) return level;
+  if (lastDigitalLevel[pin] == (int8_t)level) return level;
+  if (!traceBeginRecord()) return level;
+  traceWriteByte(TRACE_DIGITAL_EDGE | (level ? TRACE_LEVEL_BIT : 0));
+  traceWriteByte(pin);
+  lastDigitalLevel[pin] = level;
+  return level;
+}
+
+void traceActuator(uint8_t pin, bool state) {
+  if (!tracePinValid(pin)) return;
+  if (lastActuatorState[pin] == (int8_t)state) return;
+  if (!traceBeginRecord()) return;
+  traceWriteByte(TRACE_ACTUATOR | (state ? TRACE_LEVEL_BIT : 0));
+  traceWriteByte(pin);
+  lastActuatorState[pin] = state;
+}
+
+void traceCommand(uint8_t processType, bool start) {
+  // Perintah internal (dari dalam tick) bukan input, replay akan menghasilkannya sendiri
+  if (traceInTick) return;
+  if (!traceBeginRecord()) return;
+  traceWriteByte(TRACE_COMMAND | (start ? TRACE_LEVEL_BIT : 0));
+  traceWriteByte(processType);
+}
+
+void traceSettings(const uint8_t* data, size_t len) {
+  if (!traceBeginRecord(len + TRACE_MAX_RECORD)) return;
+  traceWriteByte(TRACE_SETTINGS);
+  traceWriteVarint((uint32_t)len);
+  memcpy(traceBuffer + traceLength, data, len);
+  traceLength += len;
+}
+
+// ==================== KONTROL REKAMAN ====================
+
+void startTraceRecording() {
+  traceLength = 0;
+  traceTruncated = false;
+  tracePendingTickEnd = false;
+  tracePendingTick = false;
+  traceIdleCount = 0;
+  traceTickCount = 0;
+  for (int i = 0; i < TRACE_PIN_COUNT; i++) {
+    lastDigitalLevel[i] = -1;
+    lastActuatorState[i] = -1;
+    adcLogged[i] = false;
+  }
+  tempLogged = false;
+  flowLogged = false;
+  lastFlowPulses = 0;
+  lastFlowMicros = 0;
+
+  // Titik sinkron: jadwal sampling dimulai ulang agar replay sejajar dengan device
+  traceStartMillis = millis();
+  traceLastTickMillis = traceStartMillis;
+  resetSamplingSchedule(traceStartMillis);
+
+  traceRecording = true;
+  traceSettings((const uint8_t*)&settings, sizeof(settings));
+  Serial.println("Trace: Rekaman dimulai.");
+}
+
+void stopTraceRecording() {
+  if (!traceRecording) return;
+  traceRecording = false;
+  Serial.println("Trace: Rekaman dihentikan, " + String((unsigned long)traceLength) + " byte.");
+}
+
+bool isTraceRecording() {
+  return traceRecording;
+}
+
+size_t getTraceSize() {
+  uint8_t idleRun[TRACE_MAX_RECORD];
+  return sizeof(TraceHeader) + traceLength + (traceIdleCount > 0 ? traceEncodeIdleRun(idleRun) : 0);
+}
+
+size_t writeTrace(Print& out) {
+  // Run tick kosong terakhir belum ada di buffer
+  uint8_t idleRun[TRACE_MAX_RECORD];
+  size_t idleLength = traceIdleCount > 0 ? traceEncodeIdleRun(idleRun) : 0;
+
+  TraceHeader header;
+  header.magic = TRACE_MAGIC;
+  header.version = TRACE_VERSION;
+  header.headerSize = sizeof(TraceHeader);
+  header.startMillis = traceStartMillis;
+  header.dataSize = traceLength + idleLength;
+  header.tickCount = traceTickCount;
+  header.truncated = traceTruncated ? 1 : 0;
+
+  size_t written = out.write((const uint8_t*)&header, sizeof(header));
+  written += out.write(traceBuffer, traceLength);
+  written += out.write(idleRun, idleLength);
+  return written;
+}
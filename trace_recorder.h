@@ -0,0 +1,69 @@
+#ifndef TRACE_RECORDER_H
+#define TRACE_RECORDER_H
+
+#include <Arduino.h>
+
+// ==================== FORMAT TRACE (biner, little-endian) ====================
+// File trace = TraceHeader diikuti aliran record variabel:
+//   byte 0      : bit 0-3 = TraceRecordType, bit 4 = level (untuk edge/aktuator/command)
+//   byte 1      : pin / id (hanya untuk ADC, DIGITAL_EDGE, ACTUATOR, COMMAND)
+//   payload     : varint (unsigned) atau zigzag varint (signed), lihat tiap tipe
+// Setting runtime (RuntimeSettings) dicatat di awal rekaman dan setiap kali berubah.
+// Setiap tick() yang menghasilkan record diawali TRACE_TICK. Record sesudahnya
+// adalah input/output yang terjadi selama tick tersebut, sampai TRACE_TICK_END
+// (hanya ditulis jika ada record di luar tick, misal perintah dari web) atau
+// TRACE_TICK berikutnya. Tick tanpa record digabung menjadi TRACE_IDLE_TICKS
+// (N tick berjarak sama), jadi rekaman saat idle hampir tidak memakai buffer.
+// Input hanya dicatat saat nilainya berubah: replay memakai nilai terakhir.
+#define TRACE_MAGIC          0x52544349UL // "ICTR"
+#define TRACE_VERSION        3
+#define TRACE_BUFFER_SIZE    24576        // Byte RAM untuk rekaman
+#define TRACE_MAX_RECORD     12           // Ukuran maksimal satu record
+
+enum TraceRecordType {
+  TRACE_TICK = 0,          // varint: selisih millis() dari tick sebelumnya (atau dari startMillis)
+  TRACE_TICK_END = 1,      // tanpa payload
+  TRACE_ADC = 2,           // pin + zigzag: selisih kode ADC mentah dari nilai sebelumnya
+  TRACE_TEMP = 3,          // zigzag: selisih (suhu mentah DS18B20 x 128) dari nilai sebelumnya
+  TRACE_FLOW = 4,          // varint: pulsa dalam jendela flow + varint: selisih micros() pulsa terakhir
+  TRACE_DIGITAL_EDGE = 5,  // pin, level = nilai logis baru
+  TRACE_ACTUATOR = 6,      // pin, level = state output baru
+  TRACE_COMMAND = 7,       // id = PROCESS_TYPE, level = start/stop (dari luar tick)
+  TRACE_SETTINGS = 8,      // varint: panjang + byte RuntimeSettings apa adanya
+  TRACE_IDLE_TICKS = 9     // varint: jumlah tick + varint: selisih millis() antar tick (v3)
+};
+
+#define TRACE_LEVEL_BIT      0x10
+#define TRACE_TYPE_MASK      0x0F
+
+struct TraceHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t headerSize;
+  uint32_t startMillis;    // millis() saat rekaman dimulai
+  uint32_t dataSize;       // Jumlah byte record setelah header
+  uint32_t tickCount;
+  uint32_t truncated;      // 1 jika buffer penuh sebelum rekaman dihentikan
+};
+
+// ==================== TAP INPUT/OUTPUT ====================
+// Di device: mencatat nilai (jika sedang merekam) lalu mengembalikannya apa adanya.
+// Di host replay (tools/trace_replay): mengembalikan nilai dari trace.
+void traceTickBegin(unsigned long now);
+void traceTickEnd();
+int traceAnalogInput(uint8_t pin, int raw);
+float traceTemperature(float tempC);
+unsigned long traceFlowPulses(unsigned long pulses, unsigned long lastPulseMicros);
+bool traceDigitalInput(uint8_t pin, bool level);
+void traceActuator(uint8_t pin, bool state);
+void traceCommand(uint8_t processType, bool start);
+void traceSettings(const uint8_t* data, size_t len);
+
+// ==================== KONTROL REKAMAN (device) ====================
+void startTraceRecording();
+void stopTraceRecording();
+bool isTraceRecording();
+size_t getTraceSize();        // Header + data, dalam byte
+size_t writeTrace(Print& out); // Kirim trace lengkap (misal ke WiFiClient)
+
+#endif